@@ -12,6 +12,7 @@ using System.Linq;
 using System.Runtime.InteropServices.WindowsRuntime;
 using Windows.Foundation;
 using Windows.Foundation.Collections;
+using OverlayCore;
 
 // To learn more about WinUI, the WinUI project structure,
 // and more about our project templates, see: http://aka.ms/winui-project-info.
@@ -26,10 +27,16 @@ namespace WinUI
         public MainWindow()
         {
             InitializeComponent();
+            Closed += (_, _) => NativeOverlay.Shutdown();
         }
 
         private void ShowOverlay_Click(object sender, RoutedEventArgs e)
         {
+            if (NativeOverlay.TryShow())
+            {
+                return;
+            }
+
             var overlayWindow = new OverlayWindow();
             overlayWindow.Activate();
         }
@@ -0,0 +1,558 @@
+// Headless benchmark for the overlay render pipeline.
+//
+// Runs each stage of OverlayWindow's GDI path offscreen for a sweep of clock
+// sizes: full redraws (face, mask and hands from scratch), per-minute frames
+// (cached face plus hands, at each quality tier), incremental second-hand
+// sweep steps, mask-only passes, UpdateLayeredWindow uploads and alpha-only
+// fade frames. Uploads go to a layered window that is never shown.
+//
+//   cpp-bench [--sizes 512,1080,2160,4320] [--iterations 30]
+//             [--kernel scalar|sse2|avx2] [--csv out.csv] [--json out.json]
+//             [--baseline old.json] [--max-slowdown 0.10]
+//
+// With --baseline, a stage whose best time is more than --max-slowdown
+// slower than in the baseline JSON fails the run, as does a baseline taken
+// with another kernel or sharing no stage with this run.
+//
+//   cpp-bench --verify --golden dir [--update-golden]
+//             [--sizes 96,257,1080] [--kernel ...] [--tolerance 2]
+//
+// --verify checks pixels instead of timing them, with every supported kernel
+// unless --kernel picks one; see BenchVerify.h.
+
+#include "framework.h"
+#include "AlphaMask.h"
+#include "BenchVerify.h"
+#include "ClockContent.h"
+#include "DibSurface.h"
+#include "LayerRasterizer.h"
+#include "PixelOps.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cwchar>
+#include <functional>
+#include <string>
+#include <vector>
+#pragma comment(lib, "gdiplus.lib")
+
+static const wchar_t* BENCH_CLASS_NAME = L"OverlayBenchWindowClass";
+static const int DEFAULT_SIZES[] = { 512, 768, 1080, 1440, 2160, 2880, 4320 };
+static const int VERIFY_SIZES[] = { 96, 257, 512, 1080, 2160 };
+static const int DEFAULT_ITERATIONS = 30;
+static const double DEFAULT_MAX_SLOWDOWN = 0.10;
+
+struct BenchOptions
+{
+    std::vector<int> sizes;
+    int iterations = DEFAULT_ITERATIONS;
+    PixelKernel kernel = GetPixelKernel();
+    bool kernelGiven = false;
+    const wchar_t* csvPath = nullptr;
+    const wchar_t* jsonPath = nullptr;
+    const wchar_t* baselinePath = nullptr;
+    double maxSlowdown = DEFAULT_MAX_SLOWDOWN;
+    bool verify = false;
+    bool updateGolden = false;
+    const wchar_t* goldenDir = nullptr;
+    int tolerance = 2;
+};
+
+struct BenchResult
+{
+    int size;
+    const char* stage;
+    int iterations;
+    double minMs;
+    double avgMs;
+    double p99Ms;
+};
+
+struct BaselineResult
+{
+    int size;
+    std::string stage;
+    double minMs;
+};
+
+static double GetTicksPerMs()
+{
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    return frequency.QuadPart / 1000.0;
+}
+
+// One untimed warm-up call, then `iterations` timed calls of `body(i)`.
+static BenchResult Measure(int size, const char* stage, int iterations, const std::function<void(int)>& body)
+{
+    static const double s_ticksPerMs = GetTicksPerMs();
+
+    body(0);
+
+    std::vector<double> samples(iterations);
+    for (int i = 0; i < iterations; ++i)
+    {
+        LARGE_INTEGER start;
+        LARGE_INTEGER end;
+        QueryPerformanceCounter(&start);
+        body(i + 1);
+        QueryPerformanceCounter(&end);
+        samples[i] = (end.QuadPart - start.QuadPart) / s_ticksPerMs;
+    }
+
+    BenchResult result = { size, stage, iterations, 0.0, 0.0, 0.0 };
+    double total = 0.0;
+    for (double sample : samples)
+    {
+        total += sample;
+    }
+    std::sort(samples.begin(), samples.end());
+    result.minMs = samples.front();
+    result.avgMs = total / iterations;
+    result.p99Ms = samples[min(samples.size() - 1, (samples.size() * 99) / 100)];
+    return result;
+}
+
+static SYSTEMTIME MakeTime(int iteration)
+{
+    SYSTEMTIME time = {};
+    time.wHour = static_cast<WORD>((iteration / 60) % 24);
+    time.wMinute = static_cast<WORD>(iteration % 60);
+    return time;
+}
+
+static SYSTEMTIME MakeSweepTime(int frame)
+{
+    int ms = frame * 1000 / 60;
+    SYSTEMTIME time = {};
+    time.wHour = 10;
+    time.wMinute = 10;
+    time.wSecond = static_cast<WORD>((ms / 1000) % 60);
+    time.wMilliseconds = static_cast<WORD>(ms % 1000);
+    return time;
+}
+
+static HWND CreateBenchWindow(HINSTANCE hInstance, int size)
+{
+    return CreateWindowExW(
+        WS_EX_LAYERED | WS_EX_TOOLWINDOW,
+        BENCH_CLASS_NAME,
+        L"Overlay Bench",
+        WS_POPUP,
+        0, 0, size, size,
+        nullptr,
+        nullptr,
+        hInstance,
+        nullptr
+    );
+}
+
+static bool UploadFrame(HWND hWnd, const DibSurface& frame, BYTE alpha)
+{
+    HDC hdcScreen = GetDC(nullptr);
+    POINT ptSrc = { 0, 0 };
+    POINT ptDest = { 0, 0 };
+    SIZE sizeWnd = { frame.GetWidth(), frame.GetHeight() };
+
+    BLENDFUNCTION blend = {};
+    blend.BlendOp = AC_SRC_OVER;
+    blend.SourceConstantAlpha = alpha;
+    blend.AlphaFormat = AC_SRC_ALPHA;
+
+    BOOL uploaded = UpdateLayeredWindow(hWnd, hdcScreen, &ptDest, &sizeWnd, frame.GetHdc(), &ptSrc, 0, &blend, ULW_ALPHA);
+    ReleaseDC(nullptr, hdcScreen);
+    return uploaded != FALSE;
+}
+
+static void UpdateAlpha(HWND hWnd, BYTE alpha)
+{
+    BLENDFUNCTION blend = {};
+    blend.BlendOp = AC_SRC_OVER;
+    blend.SourceConstantAlpha = alpha;
+    blend.AlphaFormat = AC_SRC_ALPHA;
+
+    UPDATELAYEREDWINDOWINFO info = {};
+    info.cbSize = sizeof(info);
+    info.pblend = &blend;
+    info.dwFlags = ULW_ALPHA;
+    UpdateLayeredWindowIndirect(hWnd, &info);
+}
+
+static bool RunSize(HINSTANCE hInstance, int size, int iterations, std::vector<BenchResult>& results)
+{
+    const ClockContent clock;
+    const ClockContent sweepClock(SecondsDisplay::Sweep);
+    LayerRasterizer rasterizer;
+    DibSurface frame;
+    if (!rasterizer.SetSize(size) || !rasterizer.Render(frame, clock, MakeTime(0)))
+    {
+        fwprintf(stderr, L"size %d: could not create the rasterizer\n", size);
+        return false;
+    }
+
+    results.push_back(Measure(size, "full", iterations, [&](int i)
+    {
+        LayerRasterizer fresh;
+        fresh.SetSize(size);
+        fresh.Render(frame, clock, MakeTime(i));
+    }));
+
+    results.push_back(Measure(size, "frame", iterations, [&](int i)
+    {
+        rasterizer.Render(frame, clock, MakeTime(i));
+    }));
+
+    results.push_back(Measure(size, "frame-balanced", iterations, [&](int i)
+    {
+        rasterizer.Render(frame, clock, MakeTime(i), RenderQuality::Balanced);
+    }));
+
+    results.push_back(Measure(size, "frame-fast", iterations, [&](int i)
+    {
+        rasterizer.Render(frame, clock, MakeTime(i), RenderQuality::Fast);
+    }));
+
+    // One smooth-sweep step: the second hand advances by a 60 Hz frame.
+    rasterizer.Render(frame, sweepClock, MakeSweepTime(0));
+    results.push_back(Measure(size, "sweep", iterations, [&](int i)
+    {
+        RECT dirty;
+        rasterizer.RenderIncremental(frame, sweepClock, MakeSweepTime(i), MakeSweepTime(i + 1), RenderQuality::High, dirty);
+    }));
+
+    CircularAlphaMask mask;
+    mask.Build(size, 3.0f);
+    DibSurface maskTarget;
+    maskTarget.Create(size, size);
+    memset(maskTarget.GetBits(), 0xFF, static_cast<size_t>(maskTarget.GetStride()) * size);
+    results.push_back(Measure(size, "mask", iterations, [&](int)
+    {
+        mask.Apply(maskTarget.GetBits(), maskTarget.GetStride());
+    }));
+
+    HWND hWnd = CreateBenchWindow(hInstance, size);
+    if (!hWnd)
+    {
+        fwprintf(stderr, L"size %d: could not create the layered window\n", size);
+        return false;
+    }
+
+    results.push_back(Measure(size, "upload", iterations, [&](int)
+    {
+        UploadFrame(hWnd, frame, 255);
+    }));
+
+    results.push_back(Measure(size, "fade", iterations, [&](int i)
+    {
+        UpdateAlpha(hWnd, static_cast<BYTE>(255 - (i % 256)));
+    }));
+
+    DestroyWindow(hWnd);
+    return true;
+}
+
+static bool WriteCsv(const wchar_t* path, const char* kernel, const std::vector<BenchResult>& results)
+{
+    FILE* pFile = nullptr;
+    if (_wfopen_s(&pFile, path, L"w") != 0 || !pFile)
+        return false;
+
+    fprintf(pFile, "size,stage,kernel,iterations,min_ms,avg_ms,p99_ms,mpix_per_s\n");
+    for (const BenchResult& result : results)
+    {
+        double megapixels = static_cast<double>(result.size) * result.size / 1e6;
+        fprintf(pFile, "%d,%s,%s,%d,%.4f,%.4f,%.4f,%.1f\n",
+            result.size, result.stage, kernel, result.iterations,
+            result.minMs, result.avgMs, result.p99Ms, megapixels * 1000.0 / result.avgMs);
+    }
+
+    fclose(pFile);
+    return true;
+}
+
+static bool WriteJson(const wchar_t* path, const char* kernel, const std::vector<BenchResult>& results)
+{
+    FILE* pFile = nullptr;
+    if (_wfopen_s(&pFile, path, L"w") != 0 || !pFile)
+        return false;
+
+    fprintf(pFile, "{\n  \"kernel\": \"%s\",\n  \"results\": [\n", kernel);
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const BenchResult& result = results[i];
+        double megapixels = static_cast<double>(result.size) * result.size / 1e6;
+        fprintf(pFile, "    { \"size\": %d, \"stage\": \"%s\", \"iterations\": %d, \"min_ms\": %.4f, \"avg_ms\": %.4f, \"p99_ms\": %.4f, \"mpix_per_s\": %.1f }%s\n",
+            result.size, result.stage, result.iterations,
+            result.minMs, result.avgMs, result.p99Ms, megapixels * 1000.0 / result.avgMs,
+            i + 1 < results.size() ? "," : "");
+    }
+    fprintf(pFile, "  ]\n}\n");
+
+    fclose(pFile);
+    return true;
+}
+
+// Reads the kernel and results back from a file written by WriteJson.
+// Returns false unless both were found.
+static bool ReadJsonResults(const wchar_t* path, std::string& kernel, std::vector<BaselineResult>& results)
+{
+    FILE* pFile = nullptr;
+    if (_wfopen_s(&pFile, path, L"r") != 0 || !pFile)
+        return false;
+
+    char line[512];
+    while (fgets(line, sizeof(line), pFile))
+    {
+        BaselineResult result = {};
+        int iterations = 0;
+        char stage[32] = {};
+        char kernelName[16] = {};
+        if (sscanf_s(line, " \"kernel\": \"%15[^\"]\"", kernelName, static_cast<unsigned>(sizeof(kernelName))) == 1)
+        {
+            kernel = kernelName;
+        }
+        else if (sscanf_s(line, " { \"size\": %d, \"stage\": \"%31[^\"]\", \"iterations\": %d, \"min_ms\": %lf",
+            &result.size, stage, static_cast<unsigned>(sizeof(stage)), &iterations, &result.minMs) == 4)
+        {
+            result.stage = stage;
+            results.push_back(result);
+        }
+    }
+
+    fclose(pFile);
+    return !kernel.empty() && !results.empty();
+}
+
+// Compares best-of-N times, which are far less noisy than averages on a
+// desktop machine. Stages missing from either side are skipped; `matched`
+// counts the ones compared. Returns the number of stages over the limit.
+static int CompareWithBaseline(const std::vector<BenchResult>& results, const std::vector<BaselineResult>& baseline, double maxSlowdown, int& matched)
+{
+    int regressions = 0;
+    matched = 0;
+    for (const BenchResult& result : results)
+    {
+        for (const BaselineResult& previous : baseline)
+        {
+            if (previous.size != result.size || previous.stage != result.stage || previous.minMs <= 0.0)
+                continue;
+
+            ++matched;
+            double slowdown = result.minMs / previous.minMs - 1.0;
+            if (slowdown > maxSlowdown)
+            {
+                fwprintf(stderr, L"size %d %hs: %.3f ms, %.0f%% slower than the baseline %.3f ms\n",
+                    result.size, result.stage, result.minMs, slowdown * 100.0, previous.minMs);
+                ++regressions;
+            }
+            break;
+        }
+    }
+    return regressions;
+}
+
+static std::vector<int> ParseSizes(const wchar_t* text)
+{
+    std::vector<int> sizes;
+    while (*text)
+    {
+        wchar_t* pEnd = nullptr;
+        long size = wcstol(text, &pEnd, 10);
+        if (pEnd == text)
+            break;
+        if (size >= 32)
+        {
+            sizes.push_back(static_cast<int>(size));
+        }
+        text = (*pEnd == L',') ? pEnd + 1 : pEnd;
+    }
+    return sizes;
+}
+
+static bool ParseKernel(const wchar_t* text, PixelKernel& kernel)
+{
+    if (_wcsicmp(text, L"scalar") == 0)
+        kernel = PixelKernel::Scalar;
+    else if (_wcsicmp(text, L"sse2") == 0)
+        kernel = PixelKernel::Sse2;
+    else if (_wcsicmp(text, L"avx2") == 0)
+        kernel = PixelKernel::Avx2;
+    else
+        return false;
+    return true;
+}
+
+static bool ParseArguments(int argc, wchar_t** argv, BenchOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const wchar_t* arg = argv[i];
+        if (wcscmp(arg, L"--verify") == 0)
+        {
+            options.verify = true;
+            continue;
+        }
+        if (wcscmp(arg, L"--update-golden") == 0)
+        {
+            options.updateGolden = true;
+            continue;
+        }
+
+        const wchar_t* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!value)
+            return false;
+
+        if (wcscmp(arg, L"--sizes") == 0)
+            options.sizes = ParseSizes(value);
+        else if (wcscmp(arg, L"--iterations") == 0)
+            options.iterations = max(1, _wtoi(value));
+        else if (wcscmp(arg, L"--kernel") == 0)
+        {
+            if (!ParseKernel(value, options.kernel))
+                return false;
+            options.kernelGiven = true;
+        }
+        else if (wcscmp(arg, L"--csv") == 0)
+            options.csvPath = value;
+        else if (wcscmp(arg, L"--json") == 0)
+            options.jsonPath = value;
+        else if (wcscmp(arg, L"--baseline") == 0)
+            options.baselinePath = value;
+        else if (wcscmp(arg, L"--max-slowdown") == 0)
+            options.maxSlowdown = max(0.0, _wtof(value));
+        else if (wcscmp(arg, L"--golden") == 0)
+            options.goldenDir = value;
+        else if (wcscmp(arg, L"--tolerance") == 0)
+            options.tolerance = max(0, _wtoi(value));
+        else
+            return false;
+        ++i;
+    }
+
+    if ((options.verify || options.updateGolden) && !options.goldenDir)
+        return false;
+
+    if (options.sizes.empty() && options.verify)
+    {
+        options.sizes.assign(std::begin(VERIFY_SIZES), std::end(VERIFY_SIZES));
+    }
+    else if (options.sizes.empty())
+    {
+        options.sizes.assign(std::begin(DEFAULT_SIZES), std::end(DEFAULT_SIZES));
+    }
+    return true;
+}
+
+int wmain(int argc, wchar_t** argv)
+{
+    BenchOptions options;
+    if (!ParseArguments(argc, argv, options))
+    {
+        fwprintf(stderr, L"usage: cpp-bench [--sizes 512,1080,...] [--iterations N] [--kernel scalar|sse2|avx2] [--csv path] [--json path] [--baseline path] [--max-slowdown 0.10]\n"
+            L"       cpp-bench --verify --golden dir [--update-golden] [--sizes ...] [--kernel ...] [--tolerance N]\n");
+        return 2;
+    }
+
+    if (!SetPixelKernel(options.kernel))
+    {
+        fwprintf(stderr, L"the requested pixel kernel is not supported on this CPU\n");
+        return 2;
+    }
+
+    // Sizes are physical pixels, as in the app.
+    SetProcessDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
+
+    ULONG_PTR gdiplusToken = 0;
+    Gdiplus::GdiplusStartupInput gdiplusStartupInput;
+    Gdiplus::GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, nullptr);
+
+    if (options.verify)
+    {
+        VerifyOptions verifyOptions;
+        verifyOptions.sizes = options.sizes;
+        // Without --kernel, one run covers every kernel the CPU has.
+        const PixelKernel kernels[] = { PixelKernel::Scalar, PixelKernel::Sse2, PixelKernel::Avx2 };
+        for (PixelKernel kernel : kernels)
+        {
+            if (options.kernelGiven ? kernel == options.kernel : IsPixelKernelSupported(kernel))
+            {
+                verifyOptions.kernels.push_back(kernel);
+            }
+        }
+        verifyOptions.goldenDir = options.goldenDir;
+        verifyOptions.updateGolden = options.updateGolden;
+        verifyOptions.tolerance = options.tolerance;
+        int failures = RunVerify(verifyOptions);
+        wprintf(L"%d failed checks\n", failures);
+
+        Gdiplus::GdiplusShutdown(gdiplusToken);
+        return failures == 0 ? 0 : 1;
+    }
+
+    HINSTANCE hInstance = GetModuleHandleW(nullptr);
+    WNDCLASSEXW wcex = {};
+    wcex.cbSize = sizeof(WNDCLASSEX);
+    wcex.lpfnWndProc = DefWindowProcW;
+    wcex.hInstance = hInstance;
+    wcex.lpszClassName = BENCH_CLASS_NAME;
+    RegisterClassExW(&wcex);
+
+    std::vector<BenchResult> results;
+    bool succeeded = true;
+    for (int size : options.sizes)
+    {
+        succeeded = RunSize(hInstance, size, options.iterations, results) && succeeded;
+    }
+
+    const char* kernel = GetPixelKernelName(GetPixelKernel());
+    wprintf(L"%6s  %-14s %10s %10s %10s %10s\n", L"size", L"stage", L"min ms", L"avg ms", L"p99 ms", L"Mpix/s");
+    for (const BenchResult& result : results)
+    {
+        double megapixels = static_cast<double>(result.size) * result.size / 1e6;
+        wprintf(L"%6d  %-14hs %10.3f %10.3f %10.3f %10.1f\n",
+            result.size, result.stage, result.minMs, result.avgMs, result.p99Ms, megapixels * 1000.0 / result.avgMs);
+    }
+
+    if (options.csvPath && !WriteCsv(options.csvPath, kernel, results))
+    {
+        fwprintf(stderr, L"could not write %s\n", options.csvPath);
+        succeeded = false;
+    }
+    if (options.jsonPath && !WriteJson(options.jsonPath, kernel, results))
+    {
+        fwprintf(stderr, L"could not write %s\n", options.jsonPath);
+        succeeded = false;
+    }
+
+    // Timings from different kernels aren't comparable, and a baseline that
+    // shares no stage with this run checks nothing; both fail the run.
+    if (options.baselinePath)
+    {
+        std::string baselineKernel;
+        std::vector<BaselineResult> baseline;
+        int matched = 0;
+        if (!ReadJsonResults(options.baselinePath, baselineKernel, baseline))
+        {
+            fwprintf(stderr, L"could not read results from %s\n", options.baselinePath);
+            succeeded = false;
+        }
+        else if (baselineKernel != kernel)
+        {
+            fwprintf(stderr, L"%s was measured with the %hs kernel, this run with %hs; pass --kernel %hs to compare\n",
+                options.baselinePath, baselineKernel.c_str(), kernel, baselineKernel.c_str());
+            succeeded = false;
+        }
+        else if (CompareWithBaseline(results, baseline, options.maxSlowdown, matched) > 0)
+        {
+            succeeded = false;
+        }
+        else if (matched == 0)
+        {
+            fwprintf(stderr, L"%s has no stage at the sizes of this run\n", options.baselinePath);
+            succeeded = false;
+        }
+    }
+
+    Gdiplus::GdiplusShutdown(gdiplusToken);
+    return succeeded ? 0 : 1;
+}
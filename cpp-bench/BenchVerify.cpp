@@ -0,0 +1,413 @@
+#include "BenchVerify.h"
+#include "ClockContent.h"
+#include "DibSurface.h"
+#include "LayerRasterizer.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+using namespace Gdiplus;
+
+namespace
+{
+    struct VerifyCase
+    {
+        WORD hour;
+        WORD minute;
+        WORD second;
+        SecondsDisplay seconds;
+    };
+
+    // Hands overlapping, at right angles, far apart, and one with a second
+    // hand so the second-hand-only dirty rect is covered.
+    const VerifyCase VERIFY_CASES[] =
+    {
+        { 0, 0, 0, SecondsDisplay::None },
+        { 3, 15, 0, SecondsDisplay::None },
+        { 11, 59, 0, SecondsDisplay::None },
+        { 10, 10, 30, SecondsDisplay::Tick },
+    };
+
+    struct QualityTier
+    {
+        RenderQuality quality;
+        const char* name;
+        // Share of the frame allowed over the tolerance against the original
+        // renderer, which only draws at High. Balanced shifts the hands by
+        // half a pixel and Fast turns anti-aliasing off, so their edges
+        // differ by far more than rounding; the face is High at every tier.
+        double maxShareOver;
+    };
+
+    const QualityTier QUALITY_TIERS[] =
+    {
+        { RenderQuality::High, "high", 0.0 },
+        { RenderQuality::Balanced, "balanced", 0.04 },
+        { RenderQuality::Fast, "fast", 0.08 },
+    };
+
+    struct FrameDiff
+    {
+        int maxDelta;
+        size_t pixelsOver;
+    };
+
+    SYSTEMTIME MakeTime(WORD hour, WORD minute, WORD second)
+    {
+        SYSTEMTIME time = {};
+        time.wHour = hour;
+        time.wMinute = minute;
+        time.wSecond = second;
+        return time;
+    }
+
+    // The frame shown `ticks` updates before `testCase`.
+    SYSTEMTIME MakePreviousTime(const VerifyCase& testCase, int ticks)
+    {
+        int step = (testCase.seconds == SecondsDisplay::None ? 60 : 1) * ticks;
+        int total = ((testCase.hour * 60 + testCase.minute) * 60 + testCase.second - step + 12 * 3600) % (12 * 3600);
+        return MakeTime(static_cast<WORD>(total / 3600), static_cast<WORD>((total / 60) % 60), static_cast<WORD>(total % 60));
+    }
+
+    FrameDiff Compare(const BYTE* pActual, const BYTE* pExpected, size_t bytes, int tolerance)
+    {
+        FrameDiff diff = { 0, 0 };
+        for (size_t i = 0; i < bytes; i += 4)
+        {
+            int pixelDelta = 0;
+            for (size_t c = 0; c < 4; ++c)
+            {
+                pixelDelta = max(pixelDelta, abs(static_cast<int>(pActual[i + c]) - static_cast<int>(pExpected[i + c])));
+            }
+            diff.maxDelta = max(diff.maxDelta, pixelDelta);
+            if (pixelDelta > tolerance)
+            {
+                ++diff.pixelsOver;
+            }
+        }
+        return diff;
+    }
+
+    // `label` names the kernel, tier and path. Passes when at most
+    // `allowedOver` pixels differ by more than the tolerance.
+    bool Check(const char* label, int size, const SYSTEMTIME& time, const FrameDiff& diff, size_t allowedOver)
+    {
+        bool passed = diff.pixelsOver <= allowedOver;
+        wprintf(L"%-4s %6d  %02u:%02u:%02u  %-28hs max delta %3d, %zu pixels over\n",
+            passed ? L"ok" : L"FAIL", size, time.wHour, time.wMinute, time.wSecond, label, diff.maxDelta, diff.pixelsOver);
+        return passed;
+    }
+
+    std::wstring GetGoldenPath(const wchar_t* dir, int size, const SYSTEMTIME& time)
+    {
+        wchar_t name[64];
+        swprintf_s(name, L"\\clock-%d-%02u%02u%02u.bmp", size, time.wHour, time.wMinute, time.wSecond);
+        return std::wstring(dir) + name;
+    }
+
+    // 32-bit top-down BMP of the premultiplied pixels, as they are uploaded.
+    bool WriteBmp(const std::wstring& path, const DibSurface& frame)
+    {
+        FILE* pFile = nullptr;
+        if (_wfopen_s(&pFile, path.c_str(), L"wb") != 0 || !pFile)
+            return false;
+
+        DWORD imageBytes = static_cast<DWORD>(frame.GetStride()) * frame.GetHeight();
+        BITMAPFILEHEADER fileHeader = {};
+        fileHeader.bfType = 0x4D42;
+        fileHeader.bfOffBits = sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER);
+        fileHeader.bfSize = fileHeader.bfOffBits + imageBytes;
+
+        BITMAPINFOHEADER infoHeader = {};
+        infoHeader.biSize = sizeof(BITMAPINFOHEADER);
+        infoHeader.biWidth = frame.GetWidth();
+        infoHeader.biHeight = -frame.GetHeight();
+        infoHeader.biPlanes = 1;
+        infoHeader.biBitCount = 32;
+        infoHeader.biCompression = BI_RGB;
+        infoHeader.biSizeImage = imageBytes;
+
+        GdiFlush();
+        bool written = fwrite(&fileHeader, sizeof(fileHeader), 1, pFile) == 1
+            && fwrite(&infoHeader, sizeof(infoHeader), 1, pFile) == 1
+            && fwrite(frame.GetBits(), imageBytes, 1, pFile) == 1;
+        fclose(pFile);
+        return written;
+    }
+
+    // Only reads what WriteBmp writes.
+    bool ReadBmp(const std::wstring& path, int size, std::vector<BYTE>& pixels)
+    {
+        FILE* pFile = nullptr;
+        if (_wfopen_s(&pFile, path.c_str(), L"rb") != 0 || !pFile)
+            return false;
+
+        BITMAPFILEHEADER fileHeader = {};
+        BITMAPINFOHEADER infoHeader = {};
+        bool valid = fread(&fileHeader, sizeof(fileHeader), 1, pFile) == 1
+            && fread(&infoHeader, sizeof(infoHeader), 1, pFile) == 1
+            && fileHeader.bfType == 0x4D42
+            && infoHeader.biWidth == size && infoHeader.biHeight == -size
+            && infoHeader.biBitCount == 32 && infoHeader.biCompression == BI_RGB
+            && fseek(pFile, static_cast<long>(fileHeader.bfOffBits), SEEK_SET) == 0;
+        if (valid)
+        {
+            pixels.resize(static_cast<size_t>(size) * size * 4);
+            valid = fread(pixels.data(), pixels.size(), 1, pFile) == 1;
+        }
+        fclose(pFile);
+        return valid;
+    }
+
+    // The renderer as it was before the layered pipeline: OverlayWindow's
+    // original CreateClockBitmap and ApplyCircularAlphaMask, copied rather
+    // than shared so that no later change to the app reaches it. The only
+    // addition is the second hand, drawn under the hub as ClockPainter does.
+    bool RenderOriginalClock(DibSurface& frame, int size, const SYSTEMTIME& time, bool showSeconds)
+    {
+        if (!frame.Create(size, size))
+            return false;
+
+        {
+            Graphics graphics(frame.GetHdc());
+            graphics.SetSmoothingMode(SmoothingModeAntiAlias);
+            graphics.SetPixelOffsetMode(PixelOffsetModeHighQuality);
+            graphics.SetCompositingQuality(CompositingQualityHighQuality);
+            graphics.SetInterpolationMode(InterpolationModeHighQualityBicubic);
+            graphics.Clear(Color(0, 0, 0, 0));
+
+            float centerX = size / 2.0f;
+            float centerY = size / 2.0f;
+            float diameter = size - 4.0f;
+            float margin = 2.0f;
+
+            SolidBrush whiteBrush(Color(255, 255, 255, 255));
+            graphics.FillEllipse(&whiteBrush, margin, margin, diameter, diameter);
+
+            Pen blackPen(Color(255, 0, 0, 0), 3.0f);
+            blackPen.SetStartCap(LineCapRound);
+            blackPen.SetEndCap(LineCapRound);
+            graphics.DrawEllipse(&blackPen, margin + 1.5f, margin + 1.5f, diameter - 3.0f, diameter - 3.0f);
+
+            double hourAngle = ((time.wHour % 12) + time.wMinute / 60.0) * 30.0;
+            double minuteAngle = time.wMinute * 6.0;
+
+            double hourRadian = (hourAngle - 90.0) * M_PI / 180.0;
+            float hourLength = (diameter / 2.0f) * 0.5f;
+            float hourEndX = centerX + hourLength * static_cast<float>(cos(hourRadian));
+            float hourEndY = centerY + hourLength * static_cast<float>(sin(hourRadian));
+
+            Pen hourPen(Color(255, 0, 0, 0), 4.0f);
+            hourPen.SetStartCap(LineCapRound);
+            hourPen.SetEndCap(LineCapRound);
+            graphics.DrawLine(&hourPen, centerX, centerY, hourEndX, hourEndY);
+
+            double minuteRadian = (minuteAngle - 90.0) * M_PI / 180.0;
+            float minuteLength = (diameter / 2.0f) * 0.7f;
+            float minuteEndX = centerX + minuteLength * static_cast<float>(cos(minuteRadian));
+            float minuteEndY = centerY + minuteLength * static_cast<float>(sin(minuteRadian));
+
+            Pen minutePen(Color(255, 0, 0, 0), 2.0f);
+            minutePen.SetStartCap(LineCapRound);
+            minutePen.SetEndCap(LineCapRound);
+            graphics.DrawLine(&minutePen, centerX, centerY, minuteEndX, minuteEndY);
+
+            if (showSeconds)
+            {
+                double secondRadian = ((time.wSecond + time.wMilliseconds / 1000.0) * 6.0 - 90.0) * M_PI / 180.0;
+                float secondLength = (diameter / 2.0f) * 0.8f;
+                float secondEndX = centerX + secondLength * static_cast<float>(cos(secondRadian));
+                float secondEndY = centerY + secondLength * static_cast<float>(sin(secondRadian));
+
+                Pen secondPen(Color(255, 0xD0, 0x20, 0x20), 1.5f);
+                secondPen.SetStartCap(LineCapRound);
+                secondPen.SetEndCap(LineCapRound);
+                graphics.DrawLine(&secondPen, centerX, centerY, secondEndX, secondEndY);
+            }
+
+            SolidBrush centerBrush(Color(255, 0, 0, 0));
+            graphics.FillEllipse(&centerBrush, centerX - 4.0f, centerY - 4.0f, 8.0f, 8.0f);
+        }
+        GdiFlush();
+
+        BYTE* pBits = frame.GetBits();
+        float center = size / 2.0f;
+        float outerRadius = size / 2.0f;
+        float innerRadius = outerRadius - 3.0f;
+        float innerRadiusSquared = innerRadius * innerRadius;
+        float outerRadiusSquared = outerRadius * outerRadius;
+
+        for (int y = 0; y < size; y++)
+        {
+            for (int x = 0; x < size; x++)
+            {
+                float dx = x + 0.5f - center;
+                float dy = y + 0.5f - center;
+                float distSquared = dx * dx + dy * dy;
+
+                BYTE* p = pBits + (static_cast<size_t>(y) * size + x) * 4;
+                BYTE a = p[3];
+                if (distSquared >= outerRadiusSquared)
+                {
+                    p[0] = p[1] = p[2] = p[3] = 0;
+                }
+                else if (distSquared >= innerRadiusSquared)
+                {
+                    float alpha = (outerRadius - sqrt(distSquared)) / (outerRadius - innerRadius);
+                    alpha = max(0.0f, min(1.0f, alpha));
+
+                    BYTE newAlpha = static_cast<BYTE>(a * alpha);
+                    p[0] = static_cast<BYTE>(p[0] * newAlpha / 255);
+                    p[1] = static_cast<BYTE>(p[1] * newAlpha / 255);
+                    p[2] = static_cast<BYTE>(p[2] * newAlpha / 255);
+                    p[3] = newAlpha;
+                }
+                else
+                {
+                    p[0] = static_cast<BYTE>(p[0] * a / 255);
+                    p[1] = static_cast<BYTE>(p[1] * a / 255);
+                    p[2] = static_cast<BYTE>(p[2] * a / 255);
+                }
+            }
+        }
+        return true;
+    }
+
+    const BYTE* GetFlushedBits(const DibSurface& frame)
+    {
+        GdiFlush();
+        return frame.GetBits();
+    }
+
+    bool CheckFrames(const char* path, const QualityTier& tier, int size, const SYSTEMTIME& time, const DibSurface& actual, const DibSurface& expected, int tolerance, size_t allowedOver)
+    {
+        char label[64];
+        sprintf_s(label, "%s %s %s", GetPixelKernelName(GetPixelKernel()), tier.name, path);
+        size_t bytes = static_cast<size_t>(size) * size * 4;
+        return Check(label, size, time, Compare(GetFlushedBits(actual), GetFlushedBits(expected), bytes, tolerance), allowedOver);
+    }
+
+    // Checks every LayerRasterizer path at one tier on the current kernel.
+    // A fresh full render has to match the original renderer; the paths
+    // that reuse earlier work then have to match that full render exactly
+    // as the tolerance allows, whatever the tier.
+    int VerifyPaths(const VerifyOptions& options, const VerifyCase& testCase, int size, const QualityTier& tier, const DibSurface& reference)
+    {
+        const ClockContent content(testCase.seconds);
+        SYSTEMTIME time = MakeTime(testCase.hour, testCase.minute, testCase.second);
+        SYSTEMTIME previous = MakePreviousTime(testCase, 1);
+        size_t allowedOver = static_cast<size_t>(tier.maxShareOver * size * size);
+        int failures = 0;
+
+        DibSurface expected;
+        LayerRasterizer full;
+        if (!full.SetSize(size) || !full.Render(expected, content, time, tier.quality))
+        {
+            fwprintf(stderr, L"size %d: could not render the %hs frame\n", size, tier.name);
+            return 1;
+        }
+        if (!CheckFrames("full", tier, size, time, expected, reference, options.tolerance, allowedOver))
+        {
+            ++failures;
+        }
+
+        // Same rasterizer, so this frame is built on the cached base.
+        DibSurface frame;
+        if (!full.Render(frame, content, previous, tier.quality) || !full.Render(frame, content, time, tier.quality)
+            || !CheckFrames("cached", tier, size, time, frame, expected, options.tolerance, 0))
+        {
+            ++failures;
+        }
+
+        RECT dirty;
+        if (!full.Render(frame, content, previous, tier.quality) || !full.RenderIncremental(frame, content, previous, time, tier.quality, dirty)
+            || !CheckFrames("incremental", tier, size, time, frame, expected, options.tolerance, 0))
+        {
+            ++failures;
+        }
+
+        // What SharedOverlayFrame does when the quality changes: a full
+        // render at the new tier over a frame drawn at another one, then
+        // incremental updates. For the ticking case only the second hand
+        // is redrawn, so any hand left over from the old tier shows here.
+        RenderQuality otherQuality = tier.quality == RenderQuality::High ? RenderQuality::Fast : RenderQuality::High;
+        if (!full.Render(frame, content, MakePreviousTime(testCase, 2), otherQuality)
+            || !full.Render(frame, content, previous, tier.quality)
+            || !full.RenderIncremental(frame, content, previous, time, tier.quality, dirty)
+            || !CheckFrames("switched", tier, size, time, frame, expected, options.tolerance, 0))
+        {
+            ++failures;
+        }
+
+        return failures;
+    }
+
+    // Checks the reference against its golden, or writes the golden.
+    int VerifyGolden(const VerifyOptions& options, int size, const SYSTEMTIME& time, const DibSurface& reference)
+    {
+        std::wstring goldenPath = GetGoldenPath(options.goldenDir, size, time);
+        if (options.updateGolden)
+        {
+            if (WriteBmp(goldenPath, reference))
+                return 0;
+
+            fwprintf(stderr, L"could not write %s\n", goldenPath.c_str());
+            return 1;
+        }
+
+        std::vector<BYTE> golden;
+        if (!ReadBmp(goldenPath, size, golden))
+        {
+            fwprintf(stderr, L"missing or unreadable golden %s\n", goldenPath.c_str());
+            return 1;
+        }
+
+        size_t bytes = static_cast<size_t>(size) * size * 4;
+        return Check("golden", size, time, Compare(GetFlushedBits(reference), golden.data(), bytes, options.tolerance), 0) ? 0 : 1;
+    }
+}
+
+int RunVerify(const VerifyOptions& options)
+{
+    if (!options.goldenDir)
+    {
+        fwprintf(stderr, L"--verify needs --golden; run once with --update-golden to create them\n");
+        return 1;
+    }
+
+    PixelKernel initialKernel = GetPixelKernel();
+    int failures = 0;
+    for (int size : options.sizes)
+    {
+        for (const VerifyCase& testCase : VERIFY_CASES)
+        {
+            // The reference is the original renderer; the golden pins it, so
+            // a GDI+ or reference change shows up as well.
+            SYSTEMTIME time = MakeTime(testCase.hour, testCase.minute, testCase.second);
+            DibSurface reference;
+            if (!RenderOriginalClock(reference, size, time, testCase.seconds != SecondsDisplay::None))
+            {
+                fwprintf(stderr, L"size %d: could not render the reference frame\n", size);
+                ++failures;
+                continue;
+            }
+            failures += VerifyGolden(options, size, time, reference);
+
+            for (PixelKernel kernel : options.kernels)
+            {
+                SetPixelKernel(kernel);
+                for (const QualityTier& tier : QUALITY_TIERS)
+                {
+                    failures += VerifyPaths(options, testCase, size, tier, reference);
+                }
+            }
+        }
+    }
+    SetPixelKernel(initialKernel);
+    return failures;
+}
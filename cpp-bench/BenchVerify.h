@@ -0,0 +1,28 @@
+#pragma once
+#include "framework.h"
+#include "PixelOps.h"
+#include <vector>
+
+struct VerifyOptions
+{
+    std::vector<int> sizes;
+    // Kernels the LayerRasterizer paths run with; every check runs once per
+    // kernel.
+    std::vector<PixelKernel> kernels;
+    // Directory of golden BMPs; required, and every golden must be there.
+    const wchar_t* goldenDir = nullptr;
+    // Write the reference frames as the new goldens instead of comparing.
+    bool updateGolden = false;
+    // Largest allowed per-channel difference of a premultiplied pixel.
+    int tolerance = 2;
+};
+
+// Renders fixed clock times at every size through each LayerRasterizer path
+// (fresh full render, cached base, incremental redraw, redraw after a
+// quality change) at the High, Balanced and Fast tiers, with each kernel.
+// Fresh full renders are compared with the original single-pass GDI+
+// renderer, kept in BenchVerify.cpp as a reference, and that with the
+// goldens; the lower tiers may differ there on a small share of edge
+// pixels. The other paths have to match the full render at their tier.
+// Returns the number of failed checks.
+int RunVerify(const VerifyOptions& options);
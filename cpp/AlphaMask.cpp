@@ -0,0 +1,157 @@
+#include "AlphaMask.h"
+#include "PixelOps.h"
+#include <cmath>
+
+CircularAlphaMask::CircularAlphaMask()
+    : m_size(0)
+{
+}
+
+bool CircularAlphaMask::Build(int size, float rimWidth)
+{
+    m_size = 0;
+    m_rows.clear();
+    m_rimCoverage.clear();
+
+    if (size <= 0)
+        return false;
+
+    float center = size / 2.0f;
+    float outerRadius = size / 2.0f;
+    float innerRadius = outerRadius - rimWidth;
+    float innerRadiusSquared = innerRadius * innerRadius;
+    float outerRadiusSquared = outerRadius * outerRadius;
+
+    m_rows.resize(size);
+    for (int y = 0; y < size; y++)
+    {
+        float dy = y + 0.5f - center;
+        RowSpan& row = m_rows[y];
+        row.left = size;
+        row.innerLeft = -1;
+        row.innerRight = -1;
+        row.right = 0;
+        row.rimOffset = static_cast<int>(m_rimCoverage.size());
+
+        // Distance along a row is convex, so each class forms one contiguous
+        // run (outside, rim, inside, rim, outside) and a single scan finds
+        // the boundaries.
+        for (int x = 0; x < size; x++)
+        {
+            float dx = x + 0.5f - center;
+            float distSquared = dx * dx + dy * dy;
+            if (distSquared >= outerRadiusSquared)
+                continue;
+
+            row.left = min(row.left, x);
+            row.right = x + 1;
+            if (distSquared < innerRadiusSquared)
+            {
+                if (row.innerLeft < 0)
+                    row.innerLeft = x;
+                row.innerRight = x + 1;
+            }
+        }
+
+        if (row.left >= row.right)
+        {
+            row.left = row.innerLeft = row.innerRight = row.right = 0;
+            continue;
+        }
+        if (row.innerLeft < 0)
+        {
+            row.innerLeft = row.innerRight = row.right;
+        }
+
+        for (int x = row.left; x < row.right; x++)
+        {
+            if (x == row.innerLeft)
+                x = row.innerRight;
+            if (x >= row.right)
+                break;
+
+            float dx = x + 0.5f - center;
+            float dist = sqrt(dx * dx + dy * dy);
+            float alpha = (outerRadius - dist) / (outerRadius - innerRadius);
+            alpha = max(0.0f, min(1.0f, alpha));
+            m_rimCoverage.push_back(static_cast<BYTE>(alpha * 255.0f + 0.5f));
+        }
+    }
+
+    m_size = size;
+    return true;
+}
+
+void CircularAlphaMask::ApplyRows(BYTE* pBits, int stride, int top, int bottom) const
+{
+    if (!pBits)
+        return;
+
+    for (int y = max(0, top); y < min(m_size, bottom); y++)
+    {
+        const RowSpan& row = m_rows[y];
+        BYTE* pRow = pBits + static_cast<size_t>(y) * stride;
+        const BYTE* pCoverage = m_rimCoverage.data() + row.rimOffset;
+
+        memset(pRow, 0, static_cast<size_t>(row.left) * 4);
+
+        for (int x = row.left; x < row.innerLeft; x++)
+        {
+            BYTE* p = pRow + x * 4;
+            BYTE a = MulDiv255(p[3], *pCoverage++);
+            p[0] = MulDiv255(p[0], a);
+            p[1] = MulDiv255(p[1], a);
+            p[2] = MulDiv255(p[2], a);
+            p[3] = a;
+        }
+
+        PremultiplyPixels(pRow + row.innerLeft * 4, row.innerRight - row.innerLeft);
+
+        for (int x = row.innerRight; x < row.right; x++)
+        {
+            BYTE* p = pRow + x * 4;
+            BYTE a = MulDiv255(p[3], *pCoverage++);
+            p[0] = MulDiv255(p[0], a);
+            p[1] = MulDiv255(p[1], a);
+            p[2] = MulDiv255(p[2], a);
+            p[3] = a;
+        }
+
+        memset(pRow + row.right * 4, 0, static_cast<size_t>(m_size - row.right) * 4);
+    }
+}
+
+void CircularAlphaMask::ApplyGrayRows(BYTE* pBits, int stride, int top, int bottom) const
+{
+    if (!pBits)
+        return;
+
+    for (int y = max(0, top); y < min(m_size, bottom); y++)
+    {
+        const RowSpan& row = m_rows[y];
+        BYTE* pRow = pBits + static_cast<size_t>(y) * stride;
+        const BYTE* pCoverage = m_rimCoverage.data() + row.rimOffset;
+
+        memset(pRow, 0, static_cast<size_t>(row.left) * 2);
+
+        for (int x = row.left; x < row.innerLeft; x++)
+        {
+            BYTE* p = pRow + x * 2;
+            BYTE a = MulDiv255(p[1], *pCoverage++);
+            p[0] = MulDiv255(p[0], a);
+            p[1] = a;
+        }
+
+        PremultiplyGrayAlphaPixels(pRow + row.innerLeft * 2, row.innerRight - row.innerLeft);
+
+        for (int x = row.innerRight; x < row.right; x++)
+        {
+            BYTE* p = pRow + x * 2;
+            BYTE a = MulDiv255(p[1], *pCoverage++);
+            p[0] = MulDiv255(p[0], a);
+            p[1] = a;
+        }
+
+        memset(pRow + row.right * 2, 0, static_cast<size_t>(m_size - row.right) * 2);
+    }
+}
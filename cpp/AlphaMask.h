@@ -0,0 +1,38 @@
+#pragma once
+#include "framework.h"
+#include <vector>
+
+// Coverage of a circle inscribed in a size x size square, with a linear fade
+// over the outermost rimWidth pixels. The geometry is resolved once in Build()
+// into per-row spans, so Apply() never evaluates distances.
+class CircularAlphaMask
+{
+private:
+    // Pixels in [left, innerLeft) and [innerRight, right) fall on the rim and
+    // have an entry in m_rimCoverage starting at rimOffset. Pixels in
+    // [innerLeft, innerRight) are fully covered, everything else is outside.
+    struct RowSpan
+    {
+        int left;
+        int innerLeft;
+        int innerRight;
+        int right;
+        int rimOffset;
+    };
+
+    int m_size;
+    std::vector<RowSpan> m_rows;
+    std::vector<BYTE> m_rimCoverage;
+
+public:
+    CircularAlphaMask();
+
+    bool Build(int size, float rimWidth);
+    void Apply(BYTE* pBits, int stride) const { ApplyRows(pBits, stride, 0, m_size); }
+    // Applies rows [top, bottom) of the mask; `pBits` is still row 0. Disjoint
+    // row ranges may be applied from different threads.
+    void ApplyRows(BYTE* pBits, int stride, int top, int bottom) const;
+    // The same for gray plus alpha pairs, as kept by GrayAlphaSurface.
+    void ApplyGrayRows(BYTE* pBits, int stride, int top, int bottom) const;
+    int GetSize() const { return m_size; }
+};
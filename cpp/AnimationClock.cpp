@@ -0,0 +1,151 @@
+#include "AnimationClock.h"
+#include <dwmapi.h>
+#pragma comment(lib, "dwmapi.lib")
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+AnimationClock::RunState::RunState(HWND hWnd, UINT msg)
+    : hWndTarget(hWnd)
+    , message(msg)
+    , hTimer(CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS))
+    , running(true)
+    , framePending(false)
+{
+    if (!hTimer)
+    {
+        // High-resolution timers need Windows 10 1803 or later.
+        hTimer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+    }
+}
+
+AnimationClock::RunState::~RunState()
+{
+    if (hTimer)
+    {
+        CloseHandle(hTimer);
+    }
+}
+
+AnimationClock::AnimationClock()
+    : m_hThread(nullptr)
+    , m_frequency()
+    , m_startTime()
+{
+    QueryPerformanceFrequency(&m_frequency);
+}
+
+AnimationClock::~AnimationClock()
+{
+    Stop();
+}
+
+bool AnimationClock::Start(HWND hWndTarget, UINT message)
+{
+    QueryPerformanceCounter(&m_startTime);
+    return Resume(hWndTarget, message);
+}
+
+// Each run gets its own state, so a thread left behind by Stop() never sees
+// the next run's target or timer.
+bool AnimationClock::Resume(HWND hWndTarget, UINT message)
+{
+    Stop();
+
+    auto state = std::make_shared<RunState>(hWndTarget, message);
+    auto* pThreadState = new std::shared_ptr<RunState>(state);
+    m_hThread = CreateThread(nullptr, 0, ThreadProc, pThreadState, 0, nullptr);
+    if (!m_hThread)
+    {
+        delete pThreadState;
+        return false;
+    }
+
+    m_state = std::move(state);
+    return true;
+}
+
+void AnimationClock::Stop()
+{
+    if (m_state)
+    {
+        m_state->running = false;
+        m_state.reset();
+    }
+
+    if (m_hThread)
+    {
+        WaitForSingleObject(m_hThread, STOP_WAIT_MS);
+        CloseHandle(m_hThread);
+        m_hThread = nullptr;
+    }
+}
+
+void AnimationClock::Restart()
+{
+    QueryPerformanceCounter(&m_startTime);
+}
+
+void AnimationClock::OnFrame()
+{
+    if (m_state)
+    {
+        m_state->framePending = false;
+    }
+}
+
+double AnimationClock::GetElapsedMs() const
+{
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return (now.QuadPart - m_startTime.QuadPart) * 1000.0 / m_frequency.QuadPart;
+}
+
+DWORD WINAPI AnimationClock::ThreadProc(LPVOID lpParameter)
+{
+    std::unique_ptr<std::shared_ptr<RunState>> state(static_cast<std::shared_ptr<RunState>*>(lpParameter));
+    Run(**state);
+    return 0;
+}
+
+void AnimationClock::Run(RunState& state)
+{
+    while (state.running)
+    {
+        if (FAILED(DwmFlush()))
+        {
+            WaitForFallbackTick(state);
+        }
+
+        if (!state.running)
+            break;
+
+        if (!state.framePending.exchange(true))
+        {
+            if (!PostMessage(state.hWndTarget, state.message, 0, 0))
+            {
+                state.framePending = false;
+            }
+        }
+    }
+}
+
+void AnimationClock::WaitForFallbackTick(RunState& state)
+{
+    if (!state.hTimer)
+    {
+        Sleep(FALLBACK_INTERVAL_MS);
+        return;
+    }
+
+    LARGE_INTEGER dueTime;
+    dueTime.QuadPart = -static_cast<LONGLONG>(FALLBACK_INTERVAL_MS) * 10000;
+    if (!SetWaitableTimer(state.hTimer, &dueTime, 0, nullptr, nullptr, FALSE))
+    {
+        Sleep(FALLBACK_INTERVAL_MS);
+        return;
+    }
+
+    WaitForSingleObject(state.hTimer, INFINITE);
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "framework.h"
+#include <atomic>
+#include <memory>
+
+// Posts a message to a window once per composition frame while running, and
+// measures elapsed time with QueryPerformanceCounter. Frames are paced by
+// DwmFlush; if composition timing is unavailable a high-resolution waitable
+// timer ticks at FALLBACK_INTERVAL_MS instead.
+//
+// At most one frame message is in flight at a time. The receiver calls
+// OnFrame() when it handles the message, which re-enables posting, so a busy
+// UI thread sees fewer frames rather than a backlog.
+//
+// DwmFlush can block for as long as DWM isn't composing, e.g. with the
+// display off or the session locked, so Stop() waits at most STOP_WAIT_MS
+// for the frame thread. A thread still blocked after that exits on its own
+// once it wakes; everything it touches is in its own RunState. A frame
+// message it posts late is at worst one extra frame for the receiver.
+class AnimationClock
+{
+private:
+    static constexpr DWORD FALLBACK_INTERVAL_MS = 16;
+    static constexpr DWORD STOP_WAIT_MS = 50;
+
+    // Shared by the clock and one frame thread, freed by whichever lets go
+    // last.
+    struct RunState
+    {
+        HWND hWndTarget;
+        UINT message;
+        HANDLE hTimer;
+        std::atomic<bool> running;
+        std::atomic<bool> framePending;
+
+        RunState(HWND hWnd, UINT msg);
+        ~RunState();
+    };
+
+    HANDLE m_hThread;
+    LARGE_INTEGER m_frequency;
+    LARGE_INTEGER m_startTime;
+    std::shared_ptr<RunState> m_state;
+
+    static DWORD WINAPI ThreadProc(LPVOID lpParameter);
+    static void Run(RunState& state);
+    static void WaitForFallbackTick(RunState& state);
+
+public:
+    AnimationClock();
+    ~AnimationClock();
+    AnimationClock(const AnimationClock&) = delete;
+    AnimationClock& operator=(const AnimationClock&) = delete;
+
+    bool Start(HWND hWndTarget, UINT message);
+    void Stop();
+    // Like Start(), but elapsed time keeps counting from the last
+    // Start() or Restart(), so a paused animation picks up where wall-clock
+    // time says it should be.
+    bool Resume(HWND hWndTarget, UINT message);
+    void Restart();
+    void OnFrame();
+    bool IsRunning() const { return m_state && m_state->running; }
+    double GetElapsedMs() const;
+};
@@ -0,0 +1,68 @@
+#include "ClockContent.h"
+#include "ClockPainter.h"
+
+ClockContent::ClockContent(SecondsDisplay seconds)
+    : m_seconds(seconds)
+{
+}
+
+// Tick and Sweep paint the same picture for the same time; the difference is
+// only in which times the overlay asks for.
+const wchar_t* ClockContent::GetContentId() const
+{
+    return ShowsSeconds() ? L"clock.seconds" : L"clock";
+}
+
+void ClockContent::PaintStaticLayer(int layer, IOverlayCanvas& canvas, int size) const
+{
+    UNREFERENCED_PARAMETER(layer);
+    PaintClockFace(canvas, size);
+}
+
+void ClockContent::PaintDynamicLayer(int layer, IOverlayCanvas& canvas, int size, const SYSTEMTIME& time) const
+{
+    UNREFERENCED_PARAMETER(layer);
+    PaintClockHands(canvas, size, time, ShowsSeconds());
+}
+
+// The hour and minute hands only depend on the hour and minute. The second
+// hand also uses the milliseconds; ticking overlays pass whole seconds.
+INT64 ClockContent::GetStateKey(const SYSTEMTIME& time) const
+{
+    INT64 key = (time.wHour % 12) * 60 + time.wMinute;
+    if (ShowsSeconds())
+    {
+        key = (key * 60 + time.wSecond) * 1000 + time.wMilliseconds;
+    }
+    return key;
+}
+
+// While only the second hand moves, just its old and new positions differ.
+RECT ClockContent::GetDirtyBounds(int size, const SYSTEMTIME& from, const SYSTEMTIME& to) const
+{
+    RECT fromBounds;
+    RECT toBounds;
+    if (ShowsSeconds() && from.wHour % 12 == to.wHour % 12 && from.wMinute == to.wMinute)
+    {
+        fromBounds = GetSecondHandBounds(size, from);
+        toBounds = GetSecondHandBounds(size, to);
+    }
+    else
+    {
+        fromBounds = GetClockHandsBounds(size, from, ShowsSeconds());
+        toBounds = GetClockHandsBounds(size, to, ShowsSeconds());
+    }
+
+    RECT dirty;
+    UnionRect(&dirty, &fromBounds, &toBounds);
+    return dirty;
+}
+
+UINT ClockContent::GetUpdateDelayMs(const SYSTEMTIME& time) const
+{
+    if (ShowsSeconds())
+        return MS_PER_SECOND - min(static_cast<UINT>(time.wMilliseconds), MS_PER_SECOND - 1);
+
+    UINT elapsedInMinute = time.wSecond * 1000u + time.wMilliseconds;
+    return MS_PER_MINUTE - min(elapsedInMinute, MS_PER_MINUTE - 1);
+}
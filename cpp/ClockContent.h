@@ -0,0 +1,32 @@
+#pragma once
+#include "framework.h"
+#include "OverlayContent.h"
+#include "OverlayOptions.h"
+
+// The analog clock: the face is the static layer, the hands the dynamic one.
+class ClockContent : public IOverlayContent
+{
+private:
+    static constexpr UINT MS_PER_MINUTE = 60000;
+    static constexpr UINT MS_PER_SECOND = 1000;
+
+    SecondsDisplay m_seconds;
+
+    bool ShowsSeconds() const { return m_seconds != SecondsDisplay::None; }
+
+public:
+    explicit ClockContent(SecondsDisplay seconds = SecondsDisplay::None);
+
+    const wchar_t* GetContentId() const override;
+    OverlayShape GetShape() const override { return OverlayShape::Circle; }
+
+    int GetStaticLayerCount() const override { return 1; }
+    void PaintStaticLayer(int layer, IOverlayCanvas& canvas, int size) const override;
+    int GetDynamicLayerCount() const override { return 1; }
+    void PaintDynamicLayer(int layer, IOverlayCanvas& canvas, int size, const SYSTEMTIME& time) const override;
+
+    INT64 GetStateKey(const SYSTEMTIME& time) const override;
+    RECT GetDirtyBounds(int size, const SYSTEMTIME& from, const SYSTEMTIME& to) const override;
+    UINT GetUpdateDelayMs(const SYSTEMTIME& time) const override;
+    bool IsAnimated() const override { return m_seconds == SecondsDisplay::Sweep; }
+};
@@ -0,0 +1,124 @@
+#include "ClockPainter.h"
+#include "OverlayStats.h"
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static const DWORD CLOCK_WHITE = 0xFFFFFFFF;
+static const DWORD CLOCK_BLACK = 0xFF000000;
+static const DWORD CLOCK_RED = 0xFFD02020;
+static const float HOUR_HAND_WIDTH = 4.0f;
+static const float MINUTE_HAND_WIDTH = 2.0f;
+static const float SECOND_HAND_WIDTH = 1.5f;
+static const float HUB_RADIUS = 4.0f;
+
+struct HandGeometry
+{
+    float centerX;
+    float centerY;
+    float hourEndX;
+    float hourEndY;
+    float minuteEndX;
+    float minuteEndY;
+    float secondEndX;
+    float secondEndY;
+};
+
+static void GetHandEnd(float centerX, float centerY, float length, double angle, float& endX, float& endY)
+{
+    double radian = (angle - 90.0) * M_PI / 180.0;
+    endX = centerX + length * static_cast<float>(cos(radian));
+    endY = centerY + length * static_cast<float>(sin(radian));
+}
+
+static HandGeometry GetHandGeometry(int size, const SYSTEMTIME& time)
+{
+    HandGeometry hands;
+    hands.centerX = size / 2.0f;
+    hands.centerY = size / 2.0f;
+    float radius = (size - 4.0f) / 2.0f;
+
+    double hourAngle = ((time.wHour % 12) + time.wMinute / 60.0) * 30.0;
+    double minuteAngle = time.wMinute * 6.0;
+    double secondAngle = (time.wSecond + time.wMilliseconds / 1000.0) * 6.0;
+
+    GetHandEnd(hands.centerX, hands.centerY, radius * 0.5f, hourAngle, hands.hourEndX, hands.hourEndY);
+    GetHandEnd(hands.centerX, hands.centerY, radius * 0.7f, minuteAngle, hands.minuteEndX, hands.minuteEndY);
+    GetHandEnd(hands.centerX, hands.centerY, radius * 0.8f, secondAngle, hands.secondEndX, hands.secondEndY);
+    return hands;
+}
+
+// Round caps extend half a pen width past each end; the hub is wider than
+// any pen. One more pixel covers anti-aliasing.
+static RECT GetSegmentsBounds(int size, const float* xs, const float* ys, int count)
+{
+    float pad = max(HUB_RADIUS, HOUR_HAND_WIDTH / 2) + 1.0f;
+    float left = xs[0];
+    float top = ys[0];
+    float right = xs[0];
+    float bottom = ys[0];
+    for (int i = 1; i < count; ++i)
+    {
+        left = min(left, xs[i]);
+        top = min(top, ys[i]);
+        right = max(right, xs[i]);
+        bottom = max(bottom, ys[i]);
+    }
+
+    RECT bounds;
+    bounds.left = max(0, static_cast<int>(floor(left - pad)));
+    bounds.top = max(0, static_cast<int>(floor(top - pad)));
+    bounds.right = min(size, static_cast<int>(ceil(right + pad)));
+    bounds.bottom = min(size, static_cast<int>(ceil(bottom + pad)));
+    return bounds;
+}
+
+void PaintClockFace(IOverlayCanvas& canvas, int size)
+{
+    float diameter = size - 4.0f;
+    float margin = 2.0f;
+
+    canvas.FillEllipse(CLOCK_WHITE, margin, margin, diameter, diameter);
+    canvas.DrawEllipse(CLOCK_BLACK, 3.0f, margin + 1.5f, margin + 1.5f, diameter - 3.0f, diameter - 3.0f);
+}
+
+void PaintClockHands(IOverlayCanvas& canvas, int size, const SYSTEMTIME& time, bool showSeconds)
+{
+    HandGeometry hands = GetHandGeometry(size, time);
+    canvas.DrawLine(CLOCK_BLACK, HOUR_HAND_WIDTH, hands.centerX, hands.centerY, hands.hourEndX, hands.hourEndY);
+    canvas.DrawLine(CLOCK_BLACK, MINUTE_HAND_WIDTH, hands.centerX, hands.centerY, hands.minuteEndX, hands.minuteEndY);
+    if (showSeconds)
+    {
+        canvas.DrawLine(CLOCK_RED, SECOND_HAND_WIDTH, hands.centerX, hands.centerY, hands.secondEndX, hands.secondEndY);
+    }
+    canvas.FillEllipse(CLOCK_BLACK, hands.centerX - HUB_RADIUS, hands.centerY - HUB_RADIUS, HUB_RADIUS * 2, HUB_RADIUS * 2);
+}
+
+RECT GetClockHandsBounds(int size, const SYSTEMTIME& time, bool showSeconds)
+{
+    HandGeometry hands = GetHandGeometry(size, time);
+    const float xs[] = { hands.centerX, hands.hourEndX, hands.minuteEndX, hands.secondEndX };
+    const float ys[] = { hands.centerY, hands.hourEndY, hands.minuteEndY, hands.secondEndY };
+    return GetSegmentsBounds(size, xs, ys, showSeconds ? 4 : 3);
+}
+
+RECT GetSecondHandBounds(int size, const SYSTEMTIME& time)
+{
+    HandGeometry hands = GetHandGeometry(size, time);
+    const float xs[] = { hands.centerX, hands.secondEndX };
+    const float ys[] = { hands.centerY, hands.secondEndY };
+    return GetSegmentsBounds(size, xs, ys, 2);
+}
+
+// The text block sits in the lower half of the face, clear of the hub.
+void PaintStatsHud(IOverlayCanvas& canvas, int size)
+{
+    if (!OverlayStats::Shared().IsHudEnabled())
+        return;
+
+    std::wstring text = OverlayStats::Shared().FormatSummary();
+    float emSize = max(9.0f, size / 48.0f);
+    canvas.DrawString(0xFF404040, emSize, size * 0.22f, size * 0.58f, text.c_str());
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "framework.h"
+#include "OverlayCanvas.h"
+
+// The clock picture for a size x size square, shared by every back-end.
+// The face (disc and rim) never changes for a given size. The hour and
+// minute hands depend only on the hour and minute of `time`; the optional
+// second hand also uses the milliseconds, so callers that tick once per
+// second pass a time with wMilliseconds cleared.
+void PaintClockFace(IOverlayCanvas& canvas, int size);
+void PaintClockHands(IOverlayCanvas& canvas, int size, const SYSTEMTIME& time, bool showSeconds);
+// Pixel rect that PaintClockHands touches for `time`, including stroke width
+// and anti-aliasing, clamped to the square.
+RECT GetClockHandsBounds(int size, const SYSTEMTIME& time, bool showSeconds);
+// The same for the second hand and the hub only.
+RECT GetSecondHandBounds(int size, const SYSTEMTIME& time);
+// Draws OverlayStats::FormatSummary() inside the face when the HUD is
+// enabled; does nothing otherwise.
+void PaintStatsHud(IOverlayCanvas& canvas, int size);
@@ -0,0 +1,125 @@
+#include "ClockScheduler.h"
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+ClockScheduler::ClockScheduler()
+    : m_hWndTarget(nullptr)
+    , m_message(0)
+    , m_hTimer(nullptr)
+    , m_wait(nullptr)
+{
+}
+
+ClockScheduler::~ClockScheduler()
+{
+    Stop();
+}
+
+bool ClockScheduler::Start(HWND hWndTarget, UINT message)
+{
+    Stop();
+
+    m_hTimer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (!m_hTimer)
+    {
+        // High-resolution timers need Windows 10 1803 or later.
+        m_hTimer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+        if (!m_hTimer)
+            return false;
+    }
+
+    m_wait = CreateThreadpoolWait(WaitCallback, this, nullptr);
+    if (!m_wait)
+    {
+        CloseHandle(m_hTimer);
+        m_hTimer = nullptr;
+        return false;
+    }
+
+    m_hWndTarget = hWndTarget;
+    m_message = message;
+    return true;
+}
+
+// Once this returns no callback is running or will run, so the target window
+// gets no further messages from this instance.
+void ClockScheduler::Stop()
+{
+    if (m_wait)
+    {
+        SetThreadpoolWait(m_wait, nullptr, nullptr);
+        WaitForThreadpoolWaitCallbacks(m_wait, TRUE);
+        CloseThreadpoolWait(m_wait);
+        m_wait = nullptr;
+    }
+
+    if (m_hTimer)
+    {
+        CloseHandle(m_hTimer);
+        m_hTimer = nullptr;
+    }
+}
+
+// A positive due time is absolute, in UTC FILETIME units.
+bool ClockScheduler::ArmAt(const FILETIME& dueUtc)
+{
+    if (!m_wait)
+        return false;
+
+    LARGE_INTEGER dueTime;
+    dueTime.LowPart = dueUtc.dwLowDateTime;
+    dueTime.HighPart = static_cast<LONG>(dueUtc.dwHighDateTime);
+    if (!SetWaitableTimer(m_hTimer, &dueTime, 0, nullptr, nullptr, FALSE))
+        return false;
+
+    // A thread-pool wait fires once per SetThreadpoolWait.
+    SetThreadpoolWait(m_wait, m_hTimer, nullptr);
+    return true;
+}
+
+void ClockScheduler::Cancel()
+{
+    if (!m_wait)
+        return;
+
+    SetThreadpoolWait(m_wait, nullptr, nullptr);
+    CancelWaitableTimer(m_hTimer);
+}
+
+void CALLBACK ClockScheduler::WaitCallback(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_WAIT wait, TP_WAIT_RESULT result)
+{
+    UNREFERENCED_PARAMETER(instance);
+    UNREFERENCED_PARAMETER(wait);
+    if (result != WAIT_OBJECT_0)
+        return;
+
+    ClockScheduler* pThis = static_cast<ClockScheduler*>(context);
+    PostMessage(pThis->m_hWndTarget, pThis->m_message, 0, 0);
+}
+
+void ClockScheduler::SampleTime(FILETIME& utc, SYSTEMTIME& local)
+{
+    GetSystemTimeAsFileTime(&utc);
+
+    SYSTEMTIME systemTime;
+    if (!FileTimeToSystemTime(&utc, &systemTime) || !SystemTimeToTzSpecificLocalTime(nullptr, &systemTime, &local))
+    {
+        GetLocalTime(&local);
+    }
+}
+
+FILETIME ClockScheduler::AddMs(const FILETIME& time, UINT ms)
+{
+    const ULONGLONG TICKS_PER_MS = 10000;
+    ULARGE_INTEGER value;
+    value.LowPart = time.dwLowDateTime;
+    value.HighPart = time.dwHighDateTime;
+    value.QuadPart += ms * TICKS_PER_MS;
+
+    FILETIME result;
+    result.dwLowDateTime = value.LowPart;
+    result.dwHighDateTime = value.HighPart;
+    return result;
+}
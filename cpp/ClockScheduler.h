@@ -0,0 +1,38 @@
+#pragma once
+#include "framework.h"
+
+// Posts a message to a window once, at an absolute UTC instant. The instant
+// is held by a high-resolution waitable timer that a thread-pool wait
+// watches, so nothing runs between arming and the due time: a clock without
+// animation wakes once per visible change instead of polling.
+//
+// Absolute due times follow system clock changes. The window should still
+// re-arm on WM_TIMECHANGE, because a change of time or time zone moves the
+// local instant the next change falls on.
+class ClockScheduler
+{
+private:
+    HWND m_hWndTarget;
+    UINT m_message;
+    HANDLE m_hTimer;
+    PTP_WAIT m_wait;
+
+    static void CALLBACK WaitCallback(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_WAIT wait, TP_WAIT_RESULT result);
+
+public:
+    ClockScheduler();
+    ~ClockScheduler();
+    ClockScheduler(const ClockScheduler&) = delete;
+    ClockScheduler& operator=(const ClockScheduler&) = delete;
+
+    bool Start(HWND hWndTarget, UINT message);
+    void Stop();
+    bool IsStarted() const { return m_wait != nullptr; }
+    // Replaces any pending due time.
+    bool ArmAt(const FILETIME& dueUtc);
+    void Cancel();
+
+    // Samples the clock once, as UTC for arming and as local time for drawing.
+    static void SampleTime(FILETIME& utc, SYSTEMTIME& local);
+    static FILETIME AddMs(const FILETIME& time, UINT ms);
+};
@@ -0,0 +1,279 @@
+#include "CompositionRenderer.h"
+#include "ClockPainter.h"
+#include "OverlayContent.h"
+#include "OverlayCanvas.h"
+#include "OverlayStats.h"
+#pragma comment(lib, "d3d11.lib")
+#pragma comment(lib, "dxgi.lib")
+#pragma comment(lib, "d2d1.lib")
+#pragma comment(lib, "dcomp.lib")
+#pragma comment(lib, "dwrite.lib")
+
+using Microsoft::WRL::ComPtr;
+
+// IOverlayCanvas on a D2D device context. One solid brush is recoloured
+// per call, and all strokes share a single round-cap style. Both live as
+// long as the device context.
+class Direct2DCanvas : public IOverlayCanvas
+{
+private:
+    ID2D1DeviceContext* m_context;
+    ComPtr<ID2D1SolidColorBrush> m_brush;
+    ComPtr<ID2D1StrokeStyle> m_roundCaps;
+    ComPtr<IDWriteFactory> m_writeFactory;
+    ComPtr<IDWriteTextFormat> m_textFormat;
+    float m_textEmSize;
+
+    static D2D1_COLOR_F ToColor(DWORD argb)
+    {
+        return D2D1::ColorF(argb & 0x00FFFFFF, ((argb >> 24) & 0xFF) / 255.0f);
+    }
+
+    ID2D1SolidColorBrush* Brush(DWORD argb)
+    {
+        m_brush->SetColor(ToColor(argb));
+        return m_brush.Get();
+    }
+
+public:
+    Direct2DCanvas(ID2D1Factory1* pFactory, ID2D1DeviceContext* pContext)
+        : m_context(pContext)
+        , m_textEmSize(0.0f)
+    {
+        m_context->CreateSolidColorBrush(D2D1::ColorF(0), &m_brush);
+
+        D2D1_STROKE_STYLE_PROPERTIES props = D2D1::StrokeStyleProperties(
+            D2D1_CAP_STYLE_ROUND, D2D1_CAP_STYLE_ROUND, D2D1_CAP_STYLE_ROUND);
+        pFactory->CreateStrokeStyle(props, nullptr, 0, &m_roundCaps);
+    }
+
+    bool IsValid() const { return m_brush && m_roundCaps; }
+
+    void Clear(DWORD argb) override
+    {
+        m_context->Clear(ToColor(argb));
+    }
+
+    void FillEllipse(DWORD argb, float x, float y, float width, float height) override
+    {
+        D2D1_ELLIPSE ellipse = D2D1::Ellipse(D2D1::Point2F(x + width / 2, y + height / 2), width / 2, height / 2);
+        m_context->FillEllipse(ellipse, Brush(argb));
+    }
+
+    void DrawEllipse(DWORD argb, float strokeWidth, float x, float y, float width, float height) override
+    {
+        D2D1_ELLIPSE ellipse = D2D1::Ellipse(D2D1::Point2F(x + width / 2, y + height / 2), width / 2, height / 2);
+        m_context->DrawEllipse(ellipse, Brush(argb), strokeWidth, m_roundCaps.Get());
+    }
+
+    void DrawLine(DWORD argb, float strokeWidth, float x1, float y1, float x2, float y2) override
+    {
+        m_context->DrawLine(D2D1::Point2F(x1, y1), D2D1::Point2F(x2, y2), Brush(argb), strokeWidth, m_roundCaps.Get());
+    }
+
+    // Only the stats HUD draws text, so DirectWrite is created on demand.
+    // The text format is kept until a different size is asked for.
+    void DrawString(DWORD argb, float emSize, float x, float y, const wchar_t* text) override
+    {
+        if (!m_writeFactory && FAILED(DWriteCreateFactory(DWRITE_FACTORY_TYPE_SHARED, __uuidof(IDWriteFactory),
+            reinterpret_cast<IUnknown**>(m_writeFactory.GetAddressOf()))))
+        {
+            return;
+        }
+
+        if (!m_textFormat || m_textEmSize != emSize)
+        {
+            m_textFormat.Reset();
+            if (FAILED(m_writeFactory->CreateTextFormat(L"Segoe UI", nullptr, DWRITE_FONT_WEIGHT_NORMAL,
+                DWRITE_FONT_STYLE_NORMAL, DWRITE_FONT_STRETCH_NORMAL, emSize, L"", &m_textFormat)))
+            {
+                return;
+            }
+            m_textEmSize = emSize;
+        }
+
+        D2D1_SIZE_F targetSize = m_context->GetSize();
+        D2D1_RECT_F layout = D2D1::RectF(x, y, targetSize.width, targetSize.height);
+        m_context->DrawText(text, static_cast<UINT32>(wcslen(text)), m_textFormat.Get(), layout, Brush(argb));
+    }
+};
+
+CompositionRenderer::CompositionRenderer(std::shared_ptr<const IOverlayContent> content)
+    : m_content(std::move(content))
+    , m_size(0)
+    , m_framePending(false)
+{
+}
+
+CompositionRenderer::~CompositionRenderer() = default;
+
+bool CompositionRenderer::Initialize(int size)
+{
+    m_size = size;
+    return CreateDevice() && CreateSwapChain() && RenderBase();
+}
+
+// Hardware first, WARP second; D2D needs BGRA support either way.
+bool CompositionRenderer::CreateDevice()
+{
+    const D3D_DRIVER_TYPE driverTypes[] = { D3D_DRIVER_TYPE_HARDWARE, D3D_DRIVER_TYPE_WARP };
+    HRESULT hr = E_FAIL;
+    for (D3D_DRIVER_TYPE driverType : driverTypes)
+    {
+        hr = D3D11CreateDevice(nullptr, driverType, nullptr, D3D11_CREATE_DEVICE_BGRA_SUPPORT,
+            nullptr, 0, D3D11_SDK_VERSION, &m_d3dDevice, nullptr, nullptr);
+        if (SUCCEEDED(hr))
+            break;
+    }
+    if (FAILED(hr) || FAILED(m_d3dDevice.As(&m_dxgiDevice)))
+        return false;
+
+    if (FAILED(D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, m_d2dFactory.GetAddressOf())))
+        return false;
+
+    ComPtr<ID2D1Device> d2dDevice;
+    if (FAILED(m_d2dFactory->CreateDevice(m_dxgiDevice.Get(), &d2dDevice)))
+        return false;
+
+    if (FAILED(d2dDevice->CreateDeviceContext(D2D1_DEVICE_CONTEXT_OPTIONS_NONE, &m_d2dContext)))
+        return false;
+
+    m_canvas = std::make_unique<Direct2DCanvas>(m_d2dFactory.Get(), m_d2dContext.Get());
+    return m_canvas->IsValid();
+}
+
+bool CompositionRenderer::CreateSwapChain()
+{
+    ComPtr<IDXGIFactory2> dxgiFactory;
+    if (FAILED(CreateDXGIFactory2(0, IID_PPV_ARGS(&dxgiFactory))))
+        return false;
+
+    DXGI_SWAP_CHAIN_DESC1 desc = {};
+    desc.Width = m_size;
+    desc.Height = m_size;
+    desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+    desc.BufferCount = 2;
+    desc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
+    desc.AlphaMode = DXGI_ALPHA_MODE_PREMULTIPLIED;
+
+    if (FAILED(dxgiFactory->CreateSwapChainForComposition(m_d3dDevice.Get(), &desc, nullptr, &m_swapChain)))
+        return false;
+
+    ComPtr<IDXGISurface> backBuffer;
+    if (FAILED(m_swapChain->GetBuffer(0, IID_PPV_ARGS(&backBuffer))))
+        return false;
+
+    D2D1_BITMAP_PROPERTIES1 props = D2D1::BitmapProperties1(
+        D2D1_BITMAP_OPTIONS_TARGET | D2D1_BITMAP_OPTIONS_CANNOT_DRAW,
+        D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED));
+    return SUCCEEDED(m_d2dContext->CreateBitmapFromDxgiSurface(backBuffer.Get(), &props, &m_targetBitmap));
+}
+
+// The static layers are flattened once into a GPU bitmap and blitted under
+// the dynamic layers on every frame, mirroring LayerRasterizer's cached base.
+// A circular shape is clipped with an anti-aliased ellipse layer.
+bool CompositionRenderer::RenderBase()
+{
+    ScopedStageTimer timer(RenderStage::Face);
+    D2D1_BITMAP_PROPERTIES1 props = D2D1::BitmapProperties1(
+        D2D1_BITMAP_OPTIONS_TARGET,
+        D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED));
+    if (FAILED(m_d2dContext->CreateBitmap(D2D1::SizeU(m_size, m_size), nullptr, 0, &props, &m_baseBitmap)))
+        return false;
+
+    Direct2DCanvas& canvas = *m_canvas;
+    ComPtr<ID2D1EllipseGeometry> clip;
+    if (m_content->GetShape() == OverlayShape::Circle)
+    {
+        float radius = m_size / 2.0f;
+        if (FAILED(m_d2dFactory->CreateEllipseGeometry(D2D1::Ellipse(D2D1::Point2F(radius, radius), radius, radius), &clip)))
+            return false;
+    }
+
+    m_d2dContext->SetTarget(m_baseBitmap.Get());
+    m_d2dContext->BeginDraw();
+    canvas.Clear(0);
+    if (clip)
+    {
+        m_d2dContext->PushLayer(D2D1::LayerParameters1(D2D1::InfiniteRect(), clip.Get()), nullptr);
+    }
+    for (int layer = 0; layer < m_content->GetStaticLayerCount(); ++layer)
+    {
+        m_content->PaintStaticLayer(layer, canvas, m_size);
+    }
+    if (clip)
+    {
+        m_d2dContext->PopLayer();
+    }
+    return SUCCEEDED(m_d2dContext->EndDraw());
+}
+
+// DComp content is positioned by the window itself, so `position` is unused.
+bool CompositionRenderer::Attach(HWND hWnd, POINT position)
+{
+    // WS_EX_LAYERED stays for click-through hit testing; a fully opaque
+    // constant alpha lets DComp content through unchanged.
+    SetLayeredWindowAttributes(hWnd, 0, 255, LWA_ALPHA);
+
+    if (FAILED(DCompositionCreateDevice(m_dxgiDevice.Get(), IID_PPV_ARGS(&m_dcompDevice))))
+        return false;
+    if (FAILED(m_dcompDevice->CreateTargetForHwnd(hWnd, TRUE, &m_dcompTarget)))
+        return false;
+    if (FAILED(m_dcompDevice->CreateVisual(&m_visual)))
+        return false;
+    if (FAILED(m_dcompDevice->CreateEffectGroup(&m_effect)))
+        return false;
+
+    m_visual->SetContent(m_swapChain.Get());
+    m_visual->SetEffect(m_effect.Get());
+    m_dcompTarget->SetRoot(m_visual.Get());
+    return true;
+}
+
+// Direct2D has no cheaper anti-aliased mode, so Balanced draws like High and
+// only Fast turns anti-aliasing off.
+void CompositionRenderer::Render(const SYSTEMTIME& time, RenderQuality quality)
+{
+    if (!m_canvas)
+        return;
+
+    Direct2DCanvas& canvas = *m_canvas;
+    ScopedStageTimer timer(RenderStage::Rasterize);
+    m_d2dContext->SetTarget(m_targetBitmap.Get());
+    m_d2dContext->BeginDraw();
+    canvas.Clear(0);
+    m_d2dContext->DrawBitmap(m_baseBitmap.Get());
+    bool aliased = quality == RenderQuality::Fast;
+    m_d2dContext->SetAntialiasMode(aliased ? D2D1_ANTIALIAS_MODE_ALIASED : D2D1_ANTIALIAS_MODE_PER_PRIMITIVE);
+    m_d2dContext->SetTextAntialiasMode(aliased ? D2D1_TEXT_ANTIALIAS_MODE_ALIASED : D2D1_TEXT_ANTIALIAS_MODE_DEFAULT);
+    for (int layer = 0; layer < m_content->GetDynamicLayerCount(); ++layer)
+    {
+        m_content->PaintDynamicLayer(layer, canvas, m_size, time);
+    }
+    PaintStatsHud(canvas, m_size);
+    m_framePending = SUCCEEDED(m_d2dContext->EndDraw());
+}
+
+void CompositionRenderer::Present(BYTE alpha)
+{
+    if (m_framePending)
+    {
+        ScopedStageTimer timer(RenderStage::Upload);
+        m_swapChain->Present(1, 0);
+        m_framePending = false;
+    }
+    SetAlpha(alpha);
+}
+
+void CompositionRenderer::SetAlpha(BYTE alpha)
+{
+    if (!m_effect)
+        return;
+
+    ScopedStageTimer timer(RenderStage::AlphaUpdate);
+
+    m_effect->SetOpacity(alpha / 255.0f);
+    m_dcompDevice->Commit();
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "framework.h"
+#include "OverlayContent.h"
+#include "OverlayRenderer.h"
+#include <d3d11.h>
+#include <dxgi1_3.h>
+#include <d2d1_1.h>
+#include <dcomp.h>
+#include <dwrite.h>
+#include <wrl/client.h>
+#include <memory>
+
+// GPU back-end: Direct2D draws into a premultiplied flip-model swap chain
+// that DirectComposition shows as the window's content. The fade is a visual
+// opacity change, so it costs one DComp commit per frame and no pixel work.
+//
+// The window is created with WS_EX_NOREDIRECTIONBITMAP so DWM doesn't keep a
+// redirection surface next to the swap chain.
+class Direct2DCanvas;
+
+class CompositionRenderer : public IOverlayRenderer
+{
+private:
+    std::shared_ptr<const IOverlayContent> m_content;
+    int m_size;
+    Microsoft::WRL::ComPtr<ID3D11Device> m_d3dDevice;
+    Microsoft::WRL::ComPtr<IDXGIDevice> m_dxgiDevice;
+    Microsoft::WRL::ComPtr<IDXGISwapChain1> m_swapChain;
+    Microsoft::WRL::ComPtr<ID2D1Factory1> m_d2dFactory;
+    Microsoft::WRL::ComPtr<ID2D1DeviceContext> m_d2dContext;
+    Microsoft::WRL::ComPtr<ID2D1Bitmap1> m_targetBitmap;
+    Microsoft::WRL::ComPtr<ID2D1Bitmap1> m_baseBitmap;
+    Microsoft::WRL::ComPtr<IDCompositionDevice> m_dcompDevice;
+    Microsoft::WRL::ComPtr<IDCompositionTarget> m_dcompTarget;
+    Microsoft::WRL::ComPtr<IDCompositionVisual> m_visual;
+    Microsoft::WRL::ComPtr<IDCompositionEffectGroup> m_effect;
+    // Kept for the renderer's lifetime so its brush and stroke style are
+    // created once, not per frame.
+    std::unique_ptr<Direct2DCanvas> m_canvas;
+    bool m_framePending;
+
+    bool CreateDevice();
+    bool CreateSwapChain();
+    bool RenderBase();
+
+public:
+    explicit CompositionRenderer(std::shared_ptr<const IOverlayContent> content);
+    ~CompositionRenderer() override;
+
+    DWORD GetWindowExStyle() const override { return WS_EX_NOREDIRECTIONBITMAP; }
+    bool Initialize(int size) override;
+    bool Attach(HWND hWnd, POINT position) override;
+    void Render(const SYSTEMTIME& time, RenderQuality quality) override;
+    void Present(BYTE alpha) override;
+    void SetAlpha(BYTE alpha) override;
+};
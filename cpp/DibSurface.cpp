@@ -0,0 +1,105 @@
+#include "DibSurface.h"
+
+DibSurface::DibSurface()
+    : m_hdc(nullptr)
+    , m_hBitmap(nullptr)
+    , m_hOldBitmap(nullptr)
+    , m_pBits(nullptr)
+    , m_width(0)
+    , m_height(0)
+{
+}
+
+DibSurface::~DibSurface()
+{
+    Destroy();
+}
+
+bool DibSurface::Create(int width, int height)
+{
+    Destroy();
+
+    HDC hdcScreen = GetDC(nullptr);
+    if (!hdcScreen)
+        return false;
+
+    m_hdc = CreateCompatibleDC(hdcScreen);
+    ReleaseDC(nullptr, hdcScreen);
+    if (!m_hdc)
+        return false;
+
+    BITMAPINFO bmi = {};
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = width;
+    bmi.bmiHeader.biHeight = -height;
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    m_hBitmap = CreateDIBSection(m_hdc, &bmi, DIB_RGB_COLORS, (void**)&m_pBits, nullptr, 0);
+    if (!m_hBitmap || !m_pBits)
+    {
+        m_pBits = nullptr;
+        Destroy();
+        return false;
+    }
+
+    m_hOldBitmap = (HBITMAP)SelectObject(m_hdc, m_hBitmap);
+    m_width = width;
+    m_height = height;
+    return true;
+}
+
+void DibSurface::Destroy()
+{
+    if (m_hdc)
+    {
+        if (m_hOldBitmap)
+        {
+            SelectObject(m_hdc, m_hOldBitmap);
+        }
+        DeleteDC(m_hdc);
+    }
+    if (m_hBitmap)
+    {
+        DeleteObject(m_hBitmap);
+    }
+
+    m_hdc = nullptr;
+    m_hBitmap = nullptr;
+    m_hOldBitmap = nullptr;
+    m_pBits = nullptr;
+    m_width = 0;
+    m_height = 0;
+}
+
+void DibSurface::CopyFrom(const DibSurface& source)
+{
+    if (!m_pBits || !source.m_pBits || source.m_width != m_width || source.m_height != m_height)
+        return;
+
+    GdiFlush();
+    memcpy(m_pBits, source.m_pBits, static_cast<size_t>(GetStride()) * m_height);
+}
+
+void DibSurface::CopyRectFrom(const DibSurface& source, const RECT& rect)
+{
+    if (!m_pBits || !source.m_pBits || source.m_width != m_width || source.m_height != m_height)
+        return;
+
+    int left = max(0, static_cast<int>(rect.left));
+    int top = max(0, static_cast<int>(rect.top));
+    int right = min(m_width, static_cast<int>(rect.right));
+    int bottom = min(m_height, static_cast<int>(rect.bottom));
+    if (left >= right || top >= bottom)
+        return;
+
+    GdiFlush();
+    int stride = GetStride();
+    size_t rowBytes = static_cast<size_t>(right - left) * 4;
+    for (int y = top; y < bottom; ++y)
+    {
+        size_t offset = static_cast<size_t>(y) * stride + static_cast<size_t>(left) * 4;
+        memcpy(m_pBits + offset, source.m_pBits + offset, rowBytes);
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "framework.h"
+
+// A top-down 32bpp DIB section selected into its own memory DC.
+class DibSurface
+{
+private:
+    HDC m_hdc;
+    HBITMAP m_hBitmap;
+    HBITMAP m_hOldBitmap;
+    BYTE* m_pBits;
+    int m_width;
+    int m_height;
+
+public:
+    DibSurface();
+    ~DibSurface();
+    DibSurface(const DibSurface&) = delete;
+    DibSurface& operator=(const DibSurface&) = delete;
+
+    bool Create(int width, int height);
+    void Destroy();
+    void CopyFrom(const DibSurface& source);
+    // Copies only `rect` (clamped to the surface) from a same-sized source.
+    void CopyRectFrom(const DibSurface& source, const RECT& rect);
+
+    bool IsValid() const { return m_pBits != nullptr; }
+    HDC GetHdc() const { return m_hdc; }
+    BYTE* GetBits() const { return m_pBits; }
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+    int GetStride() const { return m_width * 4; }
+};
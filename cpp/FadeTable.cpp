@@ -0,0 +1,36 @@
+#include "FadeTable.h"
+
+FadeTable::FadeTable()
+    : m_alpha()
+    , m_durationMs(0.0)
+    , m_entriesPerMs(0.0)
+{
+    Build(FadeCurve::Linear, OverlayOptions().fadeDurationMs);
+}
+
+void FadeTable::Build(FadeCurve curve, double durationMs)
+{
+    m_durationMs = max(durationMs, MIN_DURATION_MS);
+    m_entriesPerMs = ENTRY_COUNT / m_durationMs;
+    for (size_t i = 0; i < ENTRY_COUNT; ++i)
+    {
+        double opacity = 1.0 - Evaluate(curve, static_cast<double>(i) / ENTRY_COUNT);
+        m_alpha[i] = static_cast<BYTE>(255.0 * opacity + 0.5);
+    }
+}
+
+// How far the fade has got, 0 to 1, at `progress` through the duration.
+double FadeTable::Evaluate(FadeCurve curve, double progress)
+{
+    switch (curve)
+    {
+    case FadeCurve::EaseOut:
+        return 1.0 - (1.0 - progress) * (1.0 - progress);
+    case FadeCurve::EaseIn:
+        return progress * progress;
+    case FadeCurve::EaseInOut:
+        return progress * progress * (3.0 - 2.0 * progress);
+    default:
+        return progress;
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "framework.h"
+#include "OverlayOptions.h"
+
+// Fade alpha for a curve and duration, sampled once into ENTRY_COUNT bytes so
+// a fade frame costs one multiply and a lookup. Entry i holds the alpha at
+// the start of the i-th slice of the duration.
+class FadeTable
+{
+public:
+    static constexpr size_t ENTRY_COUNT = 256;
+    // Shorter durations are raised to this, so the table never divides by
+    // zero.
+    static constexpr double MIN_DURATION_MS = 1.0;
+
+private:
+    BYTE m_alpha[ENTRY_COUNT];
+    double m_durationMs;
+    double m_entriesPerMs;
+
+    static double Evaluate(FadeCurve curve, double progress);
+
+public:
+    FadeTable();
+    void Build(FadeCurve curve, double durationMs);
+    double GetDurationMs() const { return m_durationMs; }
+    // 0 from the duration on.
+    BYTE GetAlpha(double elapsedMs) const
+    {
+        if (elapsedMs >= m_durationMs)
+            return 0;
+        if (elapsedMs <= 0.0)
+            return m_alpha[0];
+        return m_alpha[min(static_cast<size_t>(elapsedMs * m_entriesPerMs), ENTRY_COUNT - 1)];
+    }
+};
@@ -0,0 +1,70 @@
+#include "GdiPlusCanvas.h"
+
+using namespace Gdiplus;
+
+void ApplyRenderQuality(Graphics& graphics, RenderQuality quality)
+{
+    switch (quality)
+    {
+    case RenderQuality::Balanced:
+        graphics.SetSmoothingMode(SmoothingModeAntiAlias);
+        graphics.SetPixelOffsetMode(PixelOffsetModeHighSpeed);
+        graphics.SetCompositingQuality(CompositingQualityHighSpeed);
+        graphics.SetInterpolationMode(InterpolationModeBilinear);
+        break;
+
+    case RenderQuality::Fast:
+        graphics.SetSmoothingMode(SmoothingModeHighSpeed);
+        graphics.SetPixelOffsetMode(PixelOffsetModeHighSpeed);
+        graphics.SetCompositingQuality(CompositingQualityHighSpeed);
+        graphics.SetInterpolationMode(InterpolationModeNearestNeighbor);
+        break;
+
+    default:
+        graphics.SetSmoothingMode(SmoothingModeAntiAlias);
+        graphics.SetPixelOffsetMode(PixelOffsetModeHighQuality);
+        graphics.SetCompositingQuality(CompositingQualityHighQuality);
+        graphics.SetInterpolationMode(InterpolationModeHighQualityBicubic);
+        break;
+    }
+}
+
+GdiPlusCanvas::GdiPlusCanvas(Graphics& graphics)
+    : m_graphics(graphics)
+{
+}
+
+void GdiPlusCanvas::Clear(DWORD argb)
+{
+    m_graphics.Clear(Color(argb));
+}
+
+void GdiPlusCanvas::FillEllipse(DWORD argb, float x, float y, float width, float height)
+{
+    SolidBrush brush(Color(argb));
+    m_graphics.FillEllipse(&brush, x, y, width, height);
+}
+
+void GdiPlusCanvas::DrawEllipse(DWORD argb, float strokeWidth, float x, float y, float width, float height)
+{
+    Pen pen(Color(argb), strokeWidth);
+    pen.SetStartCap(LineCapRound);
+    pen.SetEndCap(LineCapRound);
+    m_graphics.DrawEllipse(&pen, x, y, width, height);
+}
+
+void GdiPlusCanvas::DrawLine(DWORD argb, float strokeWidth, float x1, float y1, float x2, float y2)
+{
+    Pen pen(Color(argb), strokeWidth);
+    pen.SetStartCap(LineCapRound);
+    pen.SetEndCap(LineCapRound);
+    m_graphics.DrawLine(&pen, x1, y1, x2, y2);
+}
+
+void GdiPlusCanvas::DrawString(DWORD argb, float emSize, float x, float y, const wchar_t* text)
+{
+    FontFamily family(L"Segoe UI");
+    Font font(&family, emSize, FontStyleRegular, UnitPixel);
+    SolidBrush brush(Color(argb));
+    m_graphics.DrawString(text, -1, &font, PointF(x, y), &brush);
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "framework.h"
+#include "OverlayCanvas.h"
+#include "OverlayOptions.h"
+
+// Sets the smoothing, pixel offset, compositing and interpolation modes for
+// a quality tier.
+void ApplyRenderQuality(Gdiplus::Graphics& graphics, RenderQuality quality);
+
+// IOverlayCanvas on top of a caller-owned GDI+ Graphics.
+class GdiPlusCanvas : public IOverlayCanvas
+{
+private:
+    Gdiplus::Graphics& m_graphics;
+
+public:
+    explicit GdiPlusCanvas(Gdiplus::Graphics& graphics);
+
+    void Clear(DWORD argb) override;
+    void FillEllipse(DWORD argb, float x, float y, float width, float height) override;
+    void DrawEllipse(DWORD argb, float strokeWidth, float x, float y, float width, float height) override;
+    void DrawLine(DWORD argb, float strokeWidth, float x1, float y1, float x2, float y2) override;
+    void DrawString(DWORD argb, float emSize, float x, float y, const wchar_t* text) override;
+};
@@ -0,0 +1,85 @@
+#include "GdiPlusRuntime.h"
+#include "OverlayStats.h"
+#pragma comment(lib, "gdiplus.lib")
+
+GdiPlusRuntime::GdiPlusRuntime()
+    : m_token(0)
+    , m_started(false)
+    , m_hPrewarmThread(nullptr)
+{
+    InitializeSRWLock(&m_lock);
+}
+
+GdiPlusRuntime::~GdiPlusRuntime()
+{
+    Shutdown();
+}
+
+GdiPlusRuntime& GdiPlusRuntime::Shared()
+{
+    static GdiPlusRuntime s_runtime;
+    return s_runtime;
+}
+
+bool GdiPlusRuntime::EnsureStarted()
+{
+    AcquireSRWLockExclusive(&m_lock);
+    if (!m_started)
+    {
+        Gdiplus::GdiplusStartupInput startupInput;
+        m_started = Gdiplus::GdiplusStartup(&m_token, &startupInput, nullptr) == Gdiplus::Ok;
+        if (m_started)
+        {
+            OverlayStats::Shared().RecordStartupPhase(StartupPhase::RendererReady);
+        }
+    }
+    bool started = m_started;
+    ReleaseSRWLockExclusive(&m_lock);
+    return started;
+}
+
+void GdiPlusRuntime::StartPrewarm()
+{
+    if (m_started || m_hPrewarmThread)
+        return;
+
+    m_hPrewarmThread = CreateThread(nullptr, 0, PrewarmThreadProc, this, 0, nullptr);
+}
+
+DWORD WINAPI GdiPlusRuntime::PrewarmThreadProc(LPVOID lpParameter)
+{
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+    static_cast<GdiPlusRuntime*>(lpParameter)->EnsureStarted();
+    return 0;
+}
+
+void GdiPlusRuntime::Shutdown()
+{
+    if (m_hPrewarmThread)
+    {
+        WaitForSingleObject(m_hPrewarmThread, INFINITE);
+        CloseHandle(m_hPrewarmThread);
+        m_hPrewarmThread = nullptr;
+    }
+
+    AcquireSRWLockExclusive(&m_lock);
+    if (m_started)
+    {
+        Gdiplus::GdiplusShutdown(m_token);
+        m_started = false;
+        m_token = 0;
+    }
+    ReleaseSRWLockExclusive(&m_lock);
+}
+
+void GdiPlusRuntime::Abandon()
+{
+    if (m_hPrewarmThread)
+    {
+        CloseHandle(m_hPrewarmThread);
+        m_hPrewarmThread = nullptr;
+    }
+
+    m_started = false;
+    m_token = 0;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "framework.h"
+
+// Starts GDI+ on first use instead of at process start. gdiplus.dll is
+// delay-loaded, so a session that never shows a GDI overlay never maps it.
+// StartPrewarm() loads it on a low-priority background thread once the
+// main window is up, so the first show doesn't pay for it either.
+class GdiPlusRuntime
+{
+private:
+    SRWLOCK m_lock;
+    ULONG_PTR m_token;
+    bool m_started;
+    HANDLE m_hPrewarmThread;
+
+    GdiPlusRuntime();
+    static DWORD WINAPI PrewarmThreadProc(LPVOID lpParameter);
+
+public:
+    ~GdiPlusRuntime();
+    GdiPlusRuntime(const GdiPlusRuntime&) = delete;
+    GdiPlusRuntime& operator=(const GdiPlusRuntime&) = delete;
+
+    static GdiPlusRuntime& Shared();
+
+    // Safe to call from any thread; blocks while another thread is starting.
+    bool EnsureStarted();
+    bool IsStarted() const { return m_started; }
+    void StartPrewarm();
+    // Call once every GDI+ object is gone.
+    void Shutdown();
+    // Leaves GDI+ to the OS, for a process exiting without Shutdown(): the
+    // prewarm thread is gone and GdiplusShutdown can't run under the loader
+    // lock. The destructor then has nothing to do.
+    void Abandon();
+};
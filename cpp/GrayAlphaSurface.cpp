@@ -0,0 +1,67 @@
+#include "GrayAlphaSurface.h"
+#include "PixelOps.h"
+
+GrayAlphaSurface::GrayAlphaSurface()
+    : m_width(0)
+    , m_height(0)
+{
+}
+
+bool GrayAlphaSurface::Create(int width, int height)
+{
+    Destroy();
+    if (width <= 0 || height <= 0)
+        return false;
+
+    m_pixels.resize(static_cast<size_t>(width) * height * 2);
+    m_width = width;
+    m_height = height;
+    return true;
+}
+
+void GrayAlphaSurface::Destroy()
+{
+    std::vector<BYTE>().swap(m_pixels);
+    m_width = 0;
+    m_height = 0;
+}
+
+bool GrayAlphaSurface::CompactRows(const DibSurface& source, int top, int bottom)
+{
+    if (!IsValid() || source.GetWidth() != m_width || source.GetHeight() != m_height)
+        return false;
+
+    for (int y = max(0, top); y < min(m_height, bottom); ++y)
+    {
+        const BYTE* pSource = source.GetBits() + static_cast<size_t>(y) * source.GetStride();
+        BYTE* pTarget = m_pixels.data() + static_cast<size_t>(y) * m_width * 2;
+        for (int x = 0; x < m_width; ++x, pSource += 4, pTarget += 2)
+        {
+            if (pSource[0] != pSource[1] || pSource[0] != pSource[2])
+                return false;
+
+            pTarget[0] = pSource[0];
+            pTarget[1] = pSource[3];
+        }
+    }
+    return true;
+}
+
+void GrayAlphaSurface::ExpandRectTo(DibSurface& target, const RECT& rect) const
+{
+    if (!IsValid() || !target.IsValid() || target.GetWidth() != m_width || target.GetHeight() != m_height)
+        return;
+
+    int left = max(0, static_cast<int>(rect.left));
+    int top = max(0, static_cast<int>(rect.top));
+    int right = min(m_width, static_cast<int>(rect.right));
+    int bottom = min(m_height, static_cast<int>(rect.bottom));
+
+    GdiFlush();
+    for (int y = top; y < bottom; ++y)
+    {
+        const BYTE* pSource = m_pixels.data() + (static_cast<size_t>(y) * m_width + left) * 2;
+        DWORD* pTarget = reinterpret_cast<DWORD*>(target.GetBits() + static_cast<size_t>(y) * target.GetStride()) + left;
+        ExpandGrayAlphaPixels(pSource, pTarget, right - left);
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "framework.h"
+#include "DibSurface.h"
+#include <vector>
+
+// Gray plus alpha, two bytes per pixel: half the size of the BGRA DibSurface
+// it is compacted from. Only exact grays fit, which covers a white face with
+// black marks and their anti-aliased edges. Compacting before masking lets
+// the mask and premultiply run on the small surface; pixels are expanded
+// back to premultiplied BGRA when copied into a frame.
+class GrayAlphaSurface
+{
+private:
+    int m_width;
+    int m_height;
+    std::vector<BYTE> m_pixels;
+
+public:
+    GrayAlphaSurface();
+
+    bool Create(int width, int height);
+    void Destroy();
+    bool IsValid() const { return !m_pixels.empty(); }
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+    BYTE* GetBits() { return m_pixels.data(); }
+    int GetStride() const { return m_width * 2; }
+
+    // Compacts rows [top, bottom) of a same-sized source. Returns false at
+    // the first pixel that isn't gray, leaving those rows incomplete.
+    // Disjoint row ranges may be compacted from different threads.
+    bool CompactRows(const DibSurface& source, int top, int bottom);
+    // Expands `rect` (clamped to the surface) into a same-sized target.
+    void ExpandRectTo(DibSurface& target, const RECT& rect) const;
+};
@@ -0,0 +1,228 @@
+#include "LayerRasterizer.h"
+#include "ClockPainter.h"
+#include "GdiPlusCanvas.h"
+#include "OverlayStats.h"
+#include "ParallelBands.h"
+#include "PixelOps.h"
+
+using namespace Gdiplus;
+
+LayerRasterizer::LayerRasterizer()
+    : m_size(0)
+{
+}
+
+bool LayerRasterizer::SetSize(int size)
+{
+    if (size == m_size)
+        return true;
+
+    m_base.Destroy();
+    m_grayBase.Destroy();
+    m_baseContentId.clear();
+    m_size = 0;
+    if (!m_mask.Build(size, RIM_WIDTH))
+        return false;
+
+    m_size = size;
+    return true;
+}
+
+bool LayerRasterizer::HasBase(const IOverlayContent& content) const
+{
+    return (m_base.IsValid() || m_grayBase.IsValid()) && m_baseContentId == content.GetContentId();
+}
+
+// Flattens the static layers into m_base once per size and content, and
+// compacts them before masking when they are all gray. The result is already
+// masked and premultiplied, so each frame only has to copy it.
+bool LayerRasterizer::RenderBase(const IOverlayContent& content)
+{
+    if (HasBase(content))
+        return true;
+
+    ScopedStageTimer timer(RenderStage::Face);
+    m_baseContentId.clear();
+    m_grayBase.Destroy();
+    if (!m_base.IsValid() && !m_base.Create(m_size, m_size))
+        return false;
+
+    ParallelBands::Run(0, m_size, [&](int top, int bottom) { PaintStaticBand(content, top, bottom); });
+    CompactBase();
+    {
+        ScopedStageTimer maskTimer(RenderStage::Mask);
+        OverlayShape shape = content.GetShape();
+        ParallelBands::Run(0, m_size, [&](int top, int bottom) { MaskBand(shape, top, bottom); });
+    }
+    m_baseContentId = content.GetContentId();
+    return true;
+}
+
+// Swaps a gray base for its compact form and frees the DIB section. Any
+// colored pixel keeps the BGRA base.
+void LayerRasterizer::CompactBase()
+{
+    if (!m_grayBase.Create(m_size, m_size))
+        return;
+
+    volatile LONG colored = FALSE;
+    ParallelBands::Run(0, m_size, [&](int top, int bottom)
+    {
+        if (!colored && !m_grayBase.CompactRows(m_base, top, bottom))
+        {
+            InterlockedExchange(&colored, TRUE);
+        }
+    });
+
+    if (colored)
+    {
+        m_grayBase.Destroy();
+        return;
+    }
+    m_base.Destroy();
+}
+
+void LayerRasterizer::RestoreRect(DibSurface& target, const RECT& rect) const
+{
+    if (m_grayBase.IsValid())
+    {
+        m_grayBase.ExpandRectTo(target, rect);
+    }
+    else
+    {
+        target.CopyRectFrom(m_base, rect);
+    }
+}
+
+// Each band is a GDI+ bitmap over its own rows of m_base, shifted so the
+// content still paints in whole-surface coordinates.
+void LayerRasterizer::PaintStaticBand(const IOverlayContent& content, int top, int bottom)
+{
+    BYTE* pRows = m_base.GetBits() + static_cast<size_t>(top) * m_base.GetStride();
+    Bitmap bitmap(m_size, bottom - top, m_base.GetStride(), PixelFormat32bppARGB, pRows);
+    Graphics graphics(&bitmap);
+    ApplyRenderQuality(graphics, RenderQuality::High);
+    graphics.TranslateTransform(0.0f, static_cast<REAL>(-top));
+
+    GdiPlusCanvas canvas(graphics);
+    canvas.Clear(0);
+    for (int layer = 0; layer < content.GetStaticLayerCount(); ++layer)
+    {
+        content.PaintStaticLayer(layer, canvas, m_size);
+    }
+}
+
+void LayerRasterizer::MaskBand(OverlayShape shape, int top, int bottom)
+{
+    if (m_grayBase.IsValid())
+    {
+        if (shape == OverlayShape::Circle)
+        {
+            m_mask.ApplyGrayRows(m_grayBase.GetBits(), m_grayBase.GetStride(), top, bottom);
+            return;
+        }
+
+        for (int y = top; y < bottom; ++y)
+        {
+            PremultiplyGrayAlphaPixels(m_grayBase.GetBits() + static_cast<size_t>(y) * m_grayBase.GetStride(), m_size);
+        }
+        return;
+    }
+
+    if (shape == OverlayShape::Circle)
+    {
+        m_mask.ApplyRows(m_base.GetBits(), m_base.GetStride(), top, bottom);
+        return;
+    }
+
+    for (int y = top; y < bottom; ++y)
+    {
+        PremultiplyPixels(m_base.GetBits() + static_cast<size_t>(y) * m_base.GetStride(), m_size);
+    }
+}
+
+bool LayerRasterizer::Render(DibSurface& target, const IOverlayContent& content, const SYSTEMTIME& time, RenderQuality quality)
+{
+    if (m_size <= 0 || !RenderBase(content))
+        return false;
+
+    ScopedStageTimer timer(RenderStage::Rasterize);
+
+    if (!target.IsValid() || target.GetWidth() != m_size)
+    {
+        if (!target.Create(m_size, m_size))
+            return false;
+    }
+
+    RenderRect(target, content, time, quality, RECT{ 0, 0, m_size, m_size });
+    return true;
+}
+
+// The stats HUD isn't covered by the content's dirty bounds, so with it
+// enabled every frame is a full one.
+bool LayerRasterizer::RenderIncremental(DibSurface& target, const IOverlayContent& content, const SYSTEMTIME& previous, const SYSTEMTIME& time, RenderQuality quality, RECT& dirty)
+{
+    if (m_size <= 0 || !HasBase(content)
+        || !target.IsValid() || target.GetWidth() != m_size
+        || OverlayStats::Shared().IsHudEnabled())
+    {
+        SetRect(&dirty, 0, 0, m_size, m_size);
+        return Render(target, content, time, quality);
+    }
+
+    ScopedStageTimer timer(RenderStage::Rasterize);
+    RECT bounds = content.GetDirtyBounds(m_size, previous, time);
+    RECT full = { 0, 0, m_size, m_size };
+    if (!IntersectRect(&dirty, &bounds, &full))
+        return true;
+
+    RenderRect(target, content, time, quality, dirty);
+    return true;
+}
+
+// Restores `rect` from the base and draws the dynamic layers over it, band
+// by band. Rects below ParallelBands' threshold, such as a second hand's
+// bounds, are a single band. The HUD is drawn once over the finished frame,
+// so every band shows the same numbers.
+void LayerRasterizer::RenderRect(DibSurface& target, const IOverlayContent& content, const SYSTEMTIME& time, RenderQuality quality, const RECT& rect)
+{
+    ParallelBands::Run(rect.top, rect.bottom, [&](int top, int bottom)
+    {
+        RestoreRect(target, RECT{ rect.left, top, rect.right, bottom });
+        PaintDynamicBand(target, content, time, quality, rect, top, bottom);
+    });
+
+    if (OverlayStats::Shared().IsHudEnabled())
+    {
+        PaintHud(target, quality);
+    }
+}
+
+// Dynamic layers are drawn straight onto the premultiplied base and are not
+// masked again; content keeps them inside its shape. The clip is set after
+// the band offset, so it stays in whole-surface coordinates.
+void LayerRasterizer::PaintDynamicBand(DibSurface& target, const IOverlayContent& content, const SYSTEMTIME& time, RenderQuality quality, const RECT& rect, int top, int bottom)
+{
+    BYTE* pRows = target.GetBits() + static_cast<size_t>(top) * target.GetStride();
+    Bitmap bitmap(m_size, bottom - top, target.GetStride(), PixelFormat32bppPARGB, pRows);
+    Graphics graphics(&bitmap);
+    ApplyRenderQuality(graphics, quality);
+    graphics.TranslateTransform(0.0f, static_cast<REAL>(-top));
+    graphics.SetClip(Rect(rect.left, top, rect.right - rect.left, bottom - top));
+
+    GdiPlusCanvas canvas(graphics);
+    for (int layer = 0; layer < content.GetDynamicLayerCount(); ++layer)
+    {
+        content.PaintDynamicLayer(layer, canvas, m_size, time);
+    }
+}
+
+void LayerRasterizer::PaintHud(DibSurface& target, RenderQuality quality)
+{
+    Bitmap bitmap(m_size, m_size, target.GetStride(), PixelFormat32bppPARGB, target.GetBits());
+    Graphics graphics(&bitmap);
+    ApplyRenderQuality(graphics, quality);
+
+    GdiPlusCanvas canvas(graphics);
+    PaintStatsHud(canvas, m_size);
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "framework.h"
+#include "DibSurface.h"
+#include "AlphaMask.h"
+#include "GrayAlphaSurface.h"
+#include "OverlayContent.h"
+#include "OverlayOptions.h"
+#include <string>
+
+// CPU renderer for overlay content. The static layers are drawn, flattened,
+// masked and premultiplied once per size and content id; each frame copies
+// that base and draws the dynamic layers on top. Frames are premultiplied
+// BGRA, ready for UpdateLayeredWindow. A base that is all grays, like the
+// clock face, is masked and kept as a GrayAlphaSurface at half the size.
+// When the target still holds an earlier frame, RenderIncremental only
+// restores and redraws the rect the content reports as dirty.
+//
+// Large surfaces are split into horizontal bands that are drawn, masked and
+// copied in parallel (see ParallelBands); each band gets its own GDI+
+// Graphics over its rows. Small clocks stay on the calling thread.
+//
+// An instance may be used from any one thread at a time.
+class LayerRasterizer
+{
+private:
+    static constexpr float RIM_WIDTH = 3.0f;
+
+    int m_size;
+    // The base is in exactly one of these once rendered.
+    DibSurface m_base;
+    GrayAlphaSurface m_grayBase;
+    std::wstring m_baseContentId;
+    CircularAlphaMask m_mask;
+
+    bool HasBase(const IOverlayContent& content) const;
+    bool RenderBase(const IOverlayContent& content);
+    void CompactBase();
+    void RestoreRect(DibSurface& target, const RECT& rect) const;
+    void PaintStaticBand(const IOverlayContent& content, int top, int bottom);
+    void MaskBand(OverlayShape shape, int top, int bottom);
+    void RenderRect(DibSurface& target, const IOverlayContent& content, const SYSTEMTIME& time, RenderQuality quality, const RECT& rect);
+    void PaintDynamicBand(DibSurface& target, const IOverlayContent& content, const SYSTEMTIME& time, RenderQuality quality, const RECT& rect, int top, int bottom);
+    void PaintHud(DibSurface& target, RenderQuality quality);
+
+public:
+    LayerRasterizer();
+
+    bool SetSize(int size);
+    int GetSize() const { return m_size; }
+    bool Render(DibSurface& target, const IOverlayContent& content, const SYSTEMTIME& time, RenderQuality quality = RenderQuality::High);
+    // `target` must hold the frame rendered for `previous` with content of
+    // the same id. Returns the changed rect in `dirty`. `quality` only
+    // applies to the dynamic layers and must be the one `target` was drawn
+    // at; after a change, render it in full first.
+    bool RenderIncremental(DibSurface& target, const IOverlayContent& content, const SYSTEMTIME& previous, const SYSTEMTIME& time, RenderQuality quality, RECT& dirty);
+};
@@ -0,0 +1,166 @@
+#include "LayeredWindowRenderer.h"
+#include "ResourcePool.h"
+#include "OverlayStats.h"
+
+LayeredWindowRenderer::LayeredWindowRenderer(bool useRenderThread, std::shared_ptr<const IOverlayContent> content)
+    : m_useRenderThread(useRenderThread)
+    , m_content(std::move(content))
+    , m_hWnd(nullptr)
+    , m_position()
+    , m_size(0)
+    , m_contentUploaded(false)
+    , m_uploadedVersion(0)
+{
+}
+
+LayeredWindowRenderer::~LayeredWindowRenderer()
+{
+    m_renderWorker.reset();
+    ResourcePool::Shared().ReleaseRasterizer(std::move(m_rasterizer));
+}
+
+bool LayeredWindowRenderer::Initialize(int size)
+{
+    m_size = size;
+    if (m_useRenderThread)
+    {
+        m_rasterizer = ResourcePool::Shared().AcquireRasterizer(size);
+        if (m_rasterizer)
+            return true;
+    }
+
+    // Also the fallback when the render thread can't be set up.
+    m_sharedFrame = ResourcePool::Shared().AcquireSharedFrame(size, m_content);
+    return m_sharedFrame != nullptr;
+}
+
+bool LayeredWindowRenderer::Attach(HWND hWnd, POINT position)
+{
+    m_hWnd = hWnd;
+    m_position = position;
+
+    if (m_rasterizer)
+    {
+        m_renderWorker = std::make_unique<RenderWorker>(*m_rasterizer, m_content);
+        if (!m_renderWorker->Start(hWnd, WM_FRAME_READY))
+        {
+            m_renderWorker.reset();
+            m_sharedFrame = ResourcePool::Shared().AcquireSharedFrame(m_size, m_content);
+            return m_sharedFrame != nullptr;
+        }
+    }
+
+    return true;
+}
+
+// With a render worker the frame is produced asynchronously and presented
+// from WM_FRAME_READY; otherwise the shared frame is brought up to date.
+void LayeredWindowRenderer::Render(const SYSTEMTIME& time, RenderQuality quality)
+{
+    if (m_renderWorker)
+    {
+        m_renderWorker->RequestFrame(time, quality);
+        return;
+    }
+
+    m_sharedFrame->Render(time, quality);
+}
+
+void LayeredWindowRenderer::Present(BYTE alpha)
+{
+    if (!m_renderWorker)
+    {
+        // Only the pixels the hands moved through go to DWM when this window
+        // already shows the previous version of the shared frame.
+        UINT version = m_sharedFrame->GetVersion();
+        if (m_contentUploaded && version == m_uploadedVersion)
+        {
+            SetAlpha(alpha);
+            return;
+        }
+
+        RECT dirty;
+        bool partial = m_contentUploaded && m_sharedFrame->GetDirtyRect(m_uploadedVersion, dirty);
+        if (UploadFrame(m_sharedFrame->GetSurface(), alpha, partial ? &dirty : nullptr))
+        {
+            m_uploadedVersion = version;
+        }
+        return;
+    }
+
+    const DibSurface* pFrame = m_renderWorker->AcquireLatestFrame();
+    if (pFrame)
+    {
+        UploadFrame(*pFrame, alpha, nullptr);
+        m_renderWorker->ReleaseFrame();
+    }
+}
+
+bool LayeredWindowRenderer::UploadFrame(const DibSurface& frame, BYTE alpha, const RECT* pDirty)
+{
+    if (!frame.IsValid())
+        return false;
+
+    ScopedStageTimer timer(RenderStage::Upload);
+
+    HDC hdcScreen = GetDC(nullptr);
+    if (!hdcScreen)
+        return false;
+
+    POINT ptSrc = { 0, 0 };
+    POINT ptDest = m_position;
+    SIZE sizeWnd = { m_size, m_size };
+
+    BLENDFUNCTION blend = {};
+    blend.BlendOp = AC_SRC_OVER;
+    blend.BlendFlags = 0;
+    blend.SourceConstantAlpha = alpha;
+    blend.AlphaFormat = AC_SRC_ALPHA;
+
+    UPDATELAYEREDWINDOWINFO info = {};
+    info.cbSize = sizeof(info);
+    info.hdcDst = hdcScreen;
+    info.pptDst = &ptDest;
+    info.psize = &sizeWnd;
+    info.hdcSrc = frame.GetHdc();
+    info.pptSrc = &ptSrc;
+    info.pblend = &blend;
+    info.dwFlags = ULW_ALPHA;
+    info.prcDirty = pDirty;
+
+    bool uploaded = UpdateLayeredWindowIndirect(m_hWnd, &info) != FALSE;
+    m_contentUploaded = m_contentUploaded || uploaded;
+
+    ReleaseDC(nullptr, hdcScreen);
+    return uploaded;
+}
+
+// Changes only the constant alpha of the layered window. Without a source DC
+// DWM keeps the pixels it already has, so fade steps don't re-copy the bitmap.
+void LayeredWindowRenderer::SetAlpha(BYTE alpha)
+{
+    if (!m_contentUploaded)
+    {
+        Present(alpha);
+        return;
+    }
+
+    ScopedStageTimer timer(RenderStage::AlphaUpdate);
+    BLENDFUNCTION blend = {};
+    blend.BlendOp = AC_SRC_OVER;
+    blend.BlendFlags = 0;
+    blend.SourceConstantAlpha = alpha;
+    blend.AlphaFormat = AC_SRC_ALPHA;
+
+    UPDATELAYEREDWINDOWINFO info = {};
+    info.cbSize = sizeof(info);
+    info.pblend = &blend;
+    info.dwFlags = ULW_ALPHA;
+
+    if (!UpdateLayeredWindowIndirect(m_hWnd, &info))
+    {
+        // Forces a full upload instead of another alpha-only attempt.
+        m_contentUploaded = false;
+        Present(alpha);
+    }
+}
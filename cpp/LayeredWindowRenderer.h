@@ -0,0 +1,41 @@
+#pragma once
+#include "framework.h"
+#include "OverlayRenderer.h"
+#include "LayerRasterizer.h"
+#include "DibSurface.h"
+#include "RenderWorker.h"
+#include "OverlayContent.h"
+#include "SharedOverlayFrame.h"
+#include <memory>
+
+// CPU back-end: GDI+ rasterizes into a premultiplied DIB section, which is
+// pushed to the layered window with UpdateLayeredWindow. Overlays of the
+// same size and content share one SharedOverlayFrame; with a render thread each overlay
+// has its own rasterizer and RenderWorker instead.
+class LayeredWindowRenderer : public IOverlayRenderer
+{
+private:
+    bool m_useRenderThread;
+    std::shared_ptr<const IOverlayContent> m_content;
+    HWND m_hWnd;
+    POINT m_position;
+    int m_size;
+    std::shared_ptr<SharedOverlayFrame> m_sharedFrame;
+    std::unique_ptr<LayerRasterizer> m_rasterizer;
+    std::unique_ptr<RenderWorker> m_renderWorker;
+    bool m_contentUploaded;
+    UINT m_uploadedVersion;
+
+    bool UploadFrame(const DibSurface& frame, BYTE alpha, const RECT* pDirty);
+
+public:
+    LayeredWindowRenderer(bool useRenderThread, std::shared_ptr<const IOverlayContent> content);
+    ~LayeredWindowRenderer() override;
+
+    DWORD GetWindowExStyle() const override { return 0; }
+    bool Initialize(int size) override;
+    bool Attach(HWND hWnd, POINT position) override;
+    void Render(const SYSTEMTIME& time, RenderQuality quality) override;
+    void Present(BYTE alpha) override;
+    void SetAlpha(BYTE alpha) override;
+};
@@ -0,0 +1,18 @@
+#pragma once
+#include "framework.h"
+
+// The few drawing primitives overlay content needs, implemented once per
+// rendering back-end. Colours are 0xAARRGGBB with straight alpha; lines are
+// drawn with round caps.
+class IOverlayCanvas
+{
+public:
+    virtual ~IOverlayCanvas() = default;
+
+    virtual void Clear(DWORD argb) = 0;
+    virtual void FillEllipse(DWORD argb, float x, float y, float width, float height) = 0;
+    virtual void DrawEllipse(DWORD argb, float strokeWidth, float x, float y, float width, float height) = 0;
+    virtual void DrawLine(DWORD argb, float strokeWidth, float x1, float y1, float x2, float y2) = 0;
+    // Multi-line text in the UI font, `emSize` in pixels, top-left at (x, y).
+    virtual void DrawString(DWORD argb, float emSize, float x, float y, const wchar_t* text) = 0;
+};
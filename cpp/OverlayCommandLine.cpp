@@ -0,0 +1,172 @@
+#include "OverlayCommandLine.h"
+#include <shellapi.h>
+#include <cwchar>
+
+namespace
+{
+    template <typename T>
+    struct NamedValue
+    {
+        const wchar_t* name;
+        T value;
+    };
+
+    const NamedValue<OverlayMonitors> MONITOR_NAMES[] =
+    {
+        { L"primary", OverlayMonitors::Primary },
+        { L"all", OverlayMonitors::All },
+        { L"cursor", OverlayMonitors::Cursor },
+        { L"foreground", OverlayMonitors::Foreground },
+    };
+
+    const NamedValue<OverlayAnchor> ANCHOR_NAMES[] =
+    {
+        { L"center", OverlayAnchor::Center },
+        { L"top-left", OverlayAnchor::TopLeft },
+        { L"top-right", OverlayAnchor::TopRight },
+        { L"bottom-left", OverlayAnchor::BottomLeft },
+        { L"bottom-right", OverlayAnchor::BottomRight },
+    };
+
+    const NamedValue<SecondsDisplay> SECONDS_NAMES[] =
+    {
+        { L"none", SecondsDisplay::None },
+        { L"tick", SecondsDisplay::Tick },
+        { L"sweep", SecondsDisplay::Sweep },
+    };
+
+    const NamedValue<OverlayBackend> BACKEND_NAMES[] =
+    {
+        { L"gdi", OverlayBackend::Gdi },
+        { L"composition", OverlayBackend::Composition },
+    };
+
+    const NamedValue<RenderQuality> QUALITY_NAMES[] =
+    {
+        { L"high", RenderQuality::High },
+        { L"balanced", RenderQuality::Balanced },
+        { L"fast", RenderQuality::Fast },
+        { L"auto", RenderQuality::Auto },
+    };
+
+    const NamedValue<FadeCurve> FADE_CURVE_NAMES[] =
+    {
+        { L"linear", FadeCurve::Linear },
+        { L"ease-out", FadeCurve::EaseOut },
+        { L"ease-in", FadeCurve::EaseIn },
+        { L"ease-in-out", FadeCurve::EaseInOut },
+    };
+
+    template <typename T, size_t N>
+    void ParseNamed(const wchar_t* text, const NamedValue<T> (&names)[N], T& value)
+    {
+        for (const NamedValue<T>& entry : names)
+        {
+            if (_wcsicmp(text, entry.name) == 0)
+            {
+                value = entry.value;
+                return;
+            }
+        }
+    }
+}
+
+bool HasCommandLineSwitch(const wchar_t* commandLine, const wchar_t* name)
+{
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(commandLine, &argc);
+    if (!argv)
+        return false;
+
+    bool found = false;
+    for (int i = 0; i < argc && !found; ++i)
+    {
+        found = _wcsicmp(argv[i], name) == 0;
+    }
+    LocalFree(argv);
+    return found;
+}
+
+OverlayOptions ParseOverlayOptions(const wchar_t* commandLine)
+{
+    OverlayOptions options;
+
+    // An empty string would make CommandLineToArgvW return the program path.
+    if (!commandLine || !*commandLine)
+        return options;
+
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(commandLine, &argc);
+    if (!argv)
+        return options;
+
+    for (int i = 0; i < argc; ++i)
+    {
+        const wchar_t* name = argv[i];
+        if (_wcsicmp(name, L"--render-thread") == 0)
+        {
+            options.useRenderThread = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+            break;
+
+        const wchar_t* value = argv[i + 1];
+        if (_wcsicmp(name, L"--monitors") == 0)
+        {
+            ParseNamed(value, MONITOR_NAMES, options.monitors);
+        }
+        else if (_wcsicmp(name, L"--anchor") == 0)
+        {
+            ParseNamed(value, ANCHOR_NAMES, options.anchor);
+        }
+        else if (_wcsicmp(name, L"--seconds") == 0)
+        {
+            ParseNamed(value, SECONDS_NAMES, options.seconds);
+        }
+        else if (_wcsicmp(name, L"--backend") == 0)
+        {
+            ParseNamed(value, BACKEND_NAMES, options.backend);
+        }
+        else if (_wcsicmp(name, L"--quality") == 0)
+        {
+            ParseNamed(value, QUALITY_NAMES, options.quality);
+        }
+        else if (_wcsicmp(name, L"--fade-curve") == 0)
+        {
+            ParseNamed(value, FADE_CURVE_NAMES, options.fadeCurve);
+        }
+        else if (_wcsicmp(name, L"--fade-ms") == 0)
+        {
+            double durationMs = wcstod(value, nullptr);
+            if (durationMs > 0.0)
+            {
+                options.fadeDurationMs = durationMs;
+            }
+        }
+        else if (_wcsicmp(name, L"--size") == 0)
+        {
+            float ratio = wcstof(value, nullptr);
+            if (ratio > 0.0f && ratio <= 1.0f)
+            {
+                options.sizeRatio = ratio;
+            }
+        }
+        else if (_wcsicmp(name, L"--margin") == 0)
+        {
+            int margin = _wtoi(value);
+            if (margin >= 0)
+            {
+                options.margin = margin;
+            }
+        }
+        else
+        {
+            continue;
+        }
+        ++i;
+    }
+
+    LocalFree(argv);
+    return options;
+}
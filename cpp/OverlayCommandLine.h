@@ -0,0 +1,18 @@
+#pragma once
+#include "framework.h"
+#include "OverlayOptions.h"
+
+// Command-line switches that describe an overlay, shared by the resident
+// instance and by `cpp.exe --show-overlay` launches that forward to it:
+//
+//   --monitors primary|all|cursor|foreground
+//   --anchor center|top-left|top-right|bottom-left|bottom-right
+//   --size <ratio>  --margin <dips>
+//   --seconds none|tick|sweep  --backend gdi|composition
+//   --quality high|balanced|fast|auto  --render-thread
+//   --fade-curve linear|ease-out|ease-in|ease-in-out  --fade-ms <ms>
+//
+// Unknown switches are left for the caller; malformed values keep the
+// default.
+bool HasCommandLineSwitch(const wchar_t* commandLine, const wchar_t* name);
+OverlayOptions ParseOverlayOptions(const wchar_t* commandLine);
@@ -0,0 +1,108 @@
+#include "OverlayCommandQueue.h"
+#include <algorithm>
+#include <dwmapi.h>
+#pragma comment(lib, "dwmapi.lib")
+
+OverlayCommandQueue::OverlayCommandQueue(OverlayManager& manager, HWND hWndTimer)
+    : m_manager(manager)
+    , m_hWndTimer(hWndTimer)
+    , m_scheduled(false)
+{
+}
+
+OverlayCommandQueue::~OverlayCommandQueue()
+{
+    if (m_scheduled)
+    {
+        KillTimer(m_hWndTimer, reinterpret_cast<UINT_PTR>(this));
+    }
+}
+
+void OverlayCommandQueue::Show(const OverlayOptions& options, std::shared_ptr<const IOverlayContent> content)
+{
+    m_pending.erase(std::remove_if(m_pending.begin(), m_pending.end(),
+        [&](const Command& command) { return command.hide || (command.options == options && command.content == content); }),
+        m_pending.end());
+    if (m_pending.size() >= MAX_PENDING_SHOWS)
+    {
+        m_pending.erase(m_pending.begin());
+    }
+
+    m_pending.push_back(Command{ false, options, std::move(content) });
+    Schedule();
+}
+
+void OverlayCommandQueue::Hide()
+{
+    m_pending.clear();
+    m_pending.push_back(Command{ true, OverlayOptions(), nullptr });
+    Schedule();
+}
+
+void OverlayCommandQueue::Flush()
+{
+    if (m_scheduled)
+    {
+        KillTimer(m_hWndTimer, reinterpret_cast<UINT_PTR>(this));
+        m_scheduled = false;
+    }
+
+    // Showing can re-enter the message loop, so work on a snapshot.
+    std::vector<Command> commands;
+    commands.swap(m_pending);
+    for (const Command& command : commands)
+    {
+        if (command.hide)
+        {
+            m_manager.HideOverlays();
+        }
+        else
+        {
+            m_manager.ShowOverlay(command.options, command.content);
+        }
+    }
+}
+
+void OverlayCommandQueue::Schedule()
+{
+    if (m_scheduled)
+        return;
+
+    m_scheduled = SetTimer(m_hWndTimer, reinterpret_cast<UINT_PTR>(this), GetMsUntilNextFrame(), TimerProc) != 0;
+    if (!m_scheduled)
+    {
+        Flush();
+    }
+}
+
+// Time to the next vblank from DWM's composition timing. Window timers are
+// coarser than a frame, so this only lines the pass up as well as USER
+// timers allow.
+UINT OverlayCommandQueue::GetMsUntilNextFrame()
+{
+    DWM_TIMING_INFO timing = {};
+    timing.cbSize = sizeof(timing);
+    LARGE_INTEGER now;
+    LARGE_INTEGER frequency;
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&frequency);
+
+    double delayMs = FALLBACK_FRAME_MS;
+    if (SUCCEEDED(DwmGetCompositionTimingInfo(nullptr, &timing)) && timing.qpcRefreshPeriod > 0)
+    {
+        LONGLONG sinceVBlank = now.QuadPart - static_cast<LONGLONG>(timing.qpcVBlank);
+        LONGLONG period = static_cast<LONGLONG>(timing.qpcRefreshPeriod);
+        LONGLONG untilNext = period - ((sinceVBlank % period) + period) % period;
+        delayMs = untilNext * 1000.0 / frequency.QuadPart;
+    }
+
+    return max(static_cast<UINT>(USER_TIMER_MINIMUM), static_cast<UINT>(delayMs + 0.5));
+}
+
+void CALLBACK OverlayCommandQueue::TimerProc(HWND hWnd, UINT message, UINT_PTR idEvent, DWORD time)
+{
+    UNREFERENCED_PARAMETER(hWnd);
+    UNREFERENCED_PARAMETER(message);
+    UNREFERENCED_PARAMETER(time);
+    reinterpret_cast<OverlayCommandQueue*>(idEvent)->Flush();
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "framework.h"
+#include "OverlayManager.h"
+#include "OverlayContent.h"
+#include "OverlayOptions.h"
+#include <memory>
+#include <vector>
+
+// Collects show and hide requests and applies them to the OverlayManager in
+// one pass on the next composition frame, so a burst from automation costs
+// one round of window work instead of one per request.
+//
+// Pending requests collapse as they arrive: a hide drops every earlier
+// request, a show drops an earlier hide and any earlier show with the same
+// options and content, and at most MAX_PENDING_SHOWS distinct shows are kept.
+// So show, hide, show applies as a single show, and the time from the last
+// request to its effect is about one frame for any burst size. UI thread
+// only.
+class OverlayCommandQueue
+{
+private:
+    static constexpr size_t MAX_PENDING_SHOWS = 4;
+    static constexpr double FALLBACK_FRAME_MS = 1000.0 / 60.0;
+
+    struct Command
+    {
+        bool hide;
+        OverlayOptions options;
+        std::shared_ptr<const IOverlayContent> content;
+    };
+
+    OverlayManager& m_manager;
+    HWND m_hWndTimer;
+    std::vector<Command> m_pending;
+    bool m_scheduled;
+
+    void Schedule();
+    static UINT GetMsUntilNextFrame();
+    static void CALLBACK TimerProc(HWND hWnd, UINT message, UINT_PTR idEvent, DWORD time);
+
+public:
+    // Timers are created on `hWndTimer`, which must outlive the queue.
+    OverlayCommandQueue(OverlayManager& manager, HWND hWndTimer);
+    ~OverlayCommandQueue();
+    OverlayCommandQueue(const OverlayCommandQueue&) = delete;
+    OverlayCommandQueue& operator=(const OverlayCommandQueue&) = delete;
+
+    void Show(const OverlayOptions& options = OverlayOptions(), std::shared_ptr<const IOverlayContent> content = nullptr);
+    void Hide();
+    // Applies everything pending now.
+    void Flush();
+    size_t GetPendingCount() const { return m_pending.size(); }
+};
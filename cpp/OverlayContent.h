@@ -0,0 +1,49 @@
+#pragma once
+#include "framework.h"
+#include "OverlayCanvas.h"
+
+// Outline of the content; static layers are masked to it with an
+// anti-aliased edge.
+enum class OverlayShape
+{
+    Square,
+    Circle,
+};
+
+// What an overlay shows, as retained layers on a size x size square.
+//
+// Static layers never change for a given size. They are painted bottom-up,
+// flattened, masked and premultiplied once, and cached by GetContentId().
+// Dynamic layers are painted on top of that cache, in order, as a pure
+// function of the time. GetStateKey() is the dirty query: two times with the
+// same key paint identically, so nothing is redrawn or uploaded between key
+// changes. GetDirtyBounds() limits a redraw to the pixels that can differ.
+//
+// Implementations are immutable after construction, so one instance can be
+// painted from the UI thread and a render worker at the same time.
+class IOverlayContent
+{
+public:
+    virtual ~IOverlayContent() = default;
+
+    // Contents with the same id paint identically for every size and time;
+    // caches and shared frames are keyed by it.
+    virtual const wchar_t* GetContentId() const = 0;
+    virtual OverlayShape GetShape() const = 0;
+
+    virtual int GetStaticLayerCount() const = 0;
+    virtual void PaintStaticLayer(int layer, IOverlayCanvas& canvas, int size) const = 0;
+    virtual int GetDynamicLayerCount() const = 0;
+    virtual void PaintDynamicLayer(int layer, IOverlayCanvas& canvas, int size, const SYSTEMTIME& time) const = 0;
+
+    virtual INT64 GetStateKey(const SYSTEMTIME& time) const = 0;
+    // Pixels the dynamic layers touch at `from` or at `to`; clamped to size.
+    virtual RECT GetDirtyBounds(int size, const SYSTEMTIME& from, const SYSTEMTIME& to) const = 0;
+    // Longest wait after `time` before the state key can change.
+    virtual UINT GetUpdateDelayMs(const SYSTEMTIME& time) const = 0;
+    // Content that changes continuously (e.g. a sweeping hand) is updated on
+    // every composition frame while visible instead of on a timer.
+    virtual bool IsAnimated() const { return false; }
+
+    bool IsDirty(INT64 renderedKey, const SYSTEMTIME& time) const { return GetStateKey(time) != renderedKey; }
+};
@@ -0,0 +1,207 @@
+#include "OverlayManager.h"
+#include "ResourcePool.h"
+#include "ClockContent.h"
+#include <algorithm>
+
+OverlayManager::OverlayManager(HINSTANCE hInstance)
+    : m_hInstance(hInstance)
+    , m_policy(OverlayPolicy::RestartExisting)
+    , m_maxConcurrent(1)
+{
+}
+
+OverlayManager::~OverlayManager()
+{
+    Clear();
+}
+
+void OverlayManager::SetPolicy(OverlayPolicy policy, size_t maxConcurrent)
+{
+    m_policy = policy;
+    m_maxConcurrent = max(static_cast<size_t>(1), maxConcurrent);
+}
+
+bool OverlayManager::ShowOverlay(const OverlayOptions& options, std::shared_ptr<const IOverlayContent> content)
+{
+    content = ResolveContent(options, std::move(content));
+    bool shown = false;
+    for (HMONITOR hMonitor : ResolveMonitors(options.monitors))
+    {
+        shown = ShowOnMonitor(options, content, hMonitor) || shown;
+    }
+    return shown;
+}
+
+void OverlayManager::HideOverlays()
+{
+    for (auto& overlay : m_overlays)
+    {
+        overlay->Hide();
+    }
+}
+
+size_t OverlayManager::Prewarm(const OverlayOptions& options, std::shared_ptr<const IOverlayContent> content)
+{
+    if (!options.reuseWindow)
+        return 0;
+
+    content = ResolveContent(options, std::move(content));
+    size_t prewarmed = 0;
+    for (HMONITOR hMonitor : ResolveMonitors(options.monitors))
+    {
+        auto overlay = std::make_unique<OverlayWindow>(m_hInstance, options, hMonitor, content);
+        if (!overlay->Create())
+            continue;
+
+        overlay->Prewarm();
+        if (!ResourcePool::Shared().ParkWindow(overlay.get()))
+            break;
+
+        overlay.release();
+        ++prewarmed;
+    }
+    return prewarmed;
+}
+
+// One instance per request, shared by the overlays on every monitor.
+std::shared_ptr<const IOverlayContent> OverlayManager::ResolveContent(const OverlayOptions& options, std::shared_ptr<const IOverlayContent> content)
+{
+    if (content)
+        return content;
+
+    return std::make_shared<ClockContent>(options.seconds);
+}
+
+std::vector<HMONITOR> OverlayManager::ResolveMonitors(OverlayMonitors monitors)
+{
+    std::vector<HMONITOR> result;
+    switch (monitors)
+    {
+    case OverlayMonitors::All:
+        EnumDisplayMonitors(nullptr, nullptr,
+            [](HMONITOR hMonitor, HDC, LPRECT, LPARAM lParam) -> BOOL
+            {
+                reinterpret_cast<std::vector<HMONITOR>*>(lParam)->push_back(hMonitor);
+                return TRUE;
+            },
+            reinterpret_cast<LPARAM>(&result));
+        break;
+
+    case OverlayMonitors::Cursor:
+        {
+            POINT cursor;
+            if (GetCursorPos(&cursor))
+            {
+                result.push_back(MonitorFromPoint(cursor, MONITOR_DEFAULTTOPRIMARY));
+            }
+        }
+        break;
+
+    case OverlayMonitors::Foreground:
+        {
+            HWND hWndForeground = GetForegroundWindow();
+            if (hWndForeground)
+            {
+                result.push_back(MonitorFromWindow(hWndForeground, MONITOR_DEFAULTTOPRIMARY));
+            }
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    if (result.empty())
+    {
+        result.push_back(MonitorFromPoint(POINT{ 0, 0 }, MONITOR_DEFAULTTOPRIMARY));
+    }
+    return result;
+}
+
+bool OverlayManager::ShowOnMonitor(const OverlayOptions& options, const std::shared_ptr<const IOverlayContent>& content, HMONITOR hMonitor)
+{
+    // Overlays on this monitor, oldest first.
+    std::vector<OverlayWindow*> existing;
+    for (auto& overlay : m_overlays)
+    {
+        if (overlay->GetMonitor() == hMonitor)
+        {
+            existing.push_back(overlay.get());
+        }
+    }
+
+    if (!existing.empty())
+    {
+        switch (m_policy)
+        {
+        case OverlayPolicy::Coalesce:
+            return true;
+
+        case OverlayPolicy::RestartExisting:
+            existing.back()->Show();
+            return true;
+
+        case OverlayPolicy::Concurrent:
+            if (existing.size() >= m_maxConcurrent)
+            {
+                auto it = std::find_if(m_overlays.begin(), m_overlays.end(),
+                    [&existing](const std::unique_ptr<OverlayWindow>& overlay) { return overlay.get() == existing.front(); });
+                std::rotate(it, it + 1, m_overlays.end());
+                m_overlays.back()->Show();
+                return true;
+            }
+            break;
+        }
+    }
+
+    OverlayWindow* pOverlay = CreateOverlay(options, content, hMonitor);
+    if (!pOverlay)
+        return false;
+
+    pOverlay->Show();
+    return true;
+}
+
+OverlayWindow* OverlayManager::CreateOverlay(const OverlayOptions& options, const std::shared_ptr<const IOverlayContent>& content, HMONITOR hMonitor)
+{
+    std::unique_ptr<OverlayWindow> overlay(ResourcePool::Shared().TakeWindow(options, *content, hMonitor));
+    if (!overlay)
+    {
+        overlay = std::make_unique<OverlayWindow>(m_hInstance, options, hMonitor, content);
+        if (!overlay->Create())
+            return nullptr;
+    }
+
+    overlay->SetFinishedCallback([this](OverlayWindow* pFinished) { OnOverlayFinished(pFinished); });
+    m_overlays.push_back(std::move(overlay));
+    return m_overlays.back().get();
+}
+
+// Called from the overlay's own window procedure as its last action, so the
+// instance can be parked or deleted here.
+void OverlayManager::OnOverlayFinished(OverlayWindow* pOverlay)
+{
+    auto it = std::find_if(m_overlays.begin(), m_overlays.end(),
+        [pOverlay](const std::unique_ptr<OverlayWindow>& overlay) { return overlay.get() == pOverlay; });
+    if (it == m_overlays.end())
+        return;
+
+    std::unique_ptr<OverlayWindow> overlay = std::move(*it);
+    m_overlays.erase(it);
+
+    overlay->SetFinishedCallback(nullptr);
+    const OverlayOptions& options = overlay->GetOptions();
+    if (options.reuseWindow && overlay->CanReuse(options, *overlay->GetContent(), overlay->GetMonitor()) && ResourcePool::Shared().ParkWindow(overlay.get()))
+    {
+        overlay.release();
+    }
+}
+
+void OverlayManager::Clear()
+{
+    for (auto& overlay : m_overlays)
+    {
+        overlay->SetFinishedCallback(nullptr);
+    }
+    m_overlays.clear();
+}
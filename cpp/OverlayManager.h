@@ -0,0 +1,57 @@
+#pragma once
+#include "framework.h"
+#include "OverlayWindow.h"
+#include "OverlayOptions.h"
+#include "OverlayContent.h"
+#include <memory>
+#include <vector>
+
+// What ShowOverlay does when an overlay is already on screen. Policies apply
+// per monitor: an overlay on one monitor never affects another monitor.
+enum class OverlayPolicy
+{
+    // Restart the fade of the most recent overlay instead of adding one.
+    RestartExisting,
+    // Leave the visible overlay alone and drop the request.
+    Coalesce,
+    // Allow up to maxConcurrent overlays; beyond that the oldest one is
+    // restarted and moved to the front.
+    Concurrent,
+};
+
+// Owns every live OverlayWindow. Finished overlays are parked in the
+// ResourcePool for reuse or deleted. Used from the UI thread only.
+class OverlayManager
+{
+private:
+    HINSTANCE m_hInstance;
+    OverlayPolicy m_policy;
+    size_t m_maxConcurrent;
+    std::vector<std::unique_ptr<OverlayWindow>> m_overlays;
+
+    static std::vector<HMONITOR> ResolveMonitors(OverlayMonitors monitors);
+    static std::shared_ptr<const IOverlayContent> ResolveContent(const OverlayOptions& options, std::shared_ptr<const IOverlayContent> content);
+    bool ShowOnMonitor(const OverlayOptions& options, const std::shared_ptr<const IOverlayContent>& content, HMONITOR hMonitor);
+    OverlayWindow* CreateOverlay(const OverlayOptions& options, const std::shared_ptr<const IOverlayContent>& content, HMONITOR hMonitor);
+    void OnOverlayFinished(OverlayWindow* pOverlay);
+
+public:
+    explicit OverlayManager(HINSTANCE hInstance);
+    ~OverlayManager();
+    OverlayManager(const OverlayManager&) = delete;
+    OverlayManager& operator=(const OverlayManager&) = delete;
+
+    void SetPolicy(OverlayPolicy policy, size_t maxConcurrent = 1);
+    // Null content shows the clock described by `options`.
+    bool ShowOverlay(const OverlayOptions& options = OverlayOptions(), std::shared_ptr<const IOverlayContent> content = nullptr);
+    // Creates hidden, fully rendered overlays for `options` and parks them in
+    // the ResourcePool, so the next ShowOverlay with the same options and
+    // content only redraws the dynamic layers and shows the window. Returns
+    // how many were parked.
+    size_t Prewarm(const OverlayOptions& options = OverlayOptions(), std::shared_ptr<const IOverlayContent> content = nullptr);
+    // Ends every live overlay's fade now. They are parked or deleted once
+    // their windows report the finish.
+    void HideOverlays();
+    size_t GetLiveCount() const { return m_overlays.size(); }
+    void Clear();
+};
@@ -0,0 +1,99 @@
+#pragma once
+#include "framework.h"
+
+// Where the clock sits on the screen.
+enum class OverlayAnchor
+{
+    Center,
+    TopLeft,
+    TopRight,
+    BottomLeft,
+    BottomRight,
+};
+
+// Which monitors get an overlay. Each one is sized for its own monitor's
+// resolution, so no monitor sees a bitmap-stretched clock.
+enum class OverlayMonitors
+{
+    Primary,
+    All,
+    // The monitor under the mouse cursor.
+    Cursor,
+    // The monitor showing most of the foreground window.
+    Foreground,
+};
+
+// How the second hand is shown, if at all.
+enum class SecondsDisplay
+{
+    None,
+    // Jumps once per second.
+    Tick,
+    // Moves on every composition frame while the overlay is visible. Drops
+    // to Tick on battery power or when frames exceed sweepBudgetMs.
+    Sweep,
+};
+
+// How the overlay gets its pixels on screen.
+enum class OverlayBackend
+{
+    // GDI+ into a DIB, UpdateLayeredWindow. Works everywhere.
+    Gdi,
+    // Direct2D into a swap chain shown through DirectComposition. Falls back
+    // to Gdi when no D3D11 device or DComp target can be created.
+    Composition,
+};
+
+// How much effort goes into drawing the dynamic layers. The static layers
+// are cached and always drawn at High.
+enum class RenderQuality
+{
+    // Anti-aliased, high-quality compositing and pixel offsets.
+    High,
+    // Anti-aliased, with the cheaper compositing and pixel offset modes.
+    Balanced,
+    // No anti-aliasing.
+    Fast,
+    // High, stepping down for frames that are mostly faded out or that take
+    // too long to draw. Resolved by OverlayWindow; renderers treat it as
+    // High.
+    Auto,
+};
+
+// How the overlay's opacity falls from 255 to 0 over fadeDurationMs.
+enum class FadeCurve
+{
+    Linear,
+    // Drops quickly at first and trails off.
+    EaseOut,
+    // Stays nearly opaque at first, then drops quickly.
+    EaseIn,
+    // Slow at both ends.
+    EaseInOut,
+};
+
+// Per-overlay settings, fixed when the overlay is created.
+struct OverlayOptions
+{
+    OverlayMonitors monitors = OverlayMonitors::Primary;
+    // Clock diameter as a fraction of min(monitor width, monitor height).
+    float sizeRatio = 0.8f;
+    OverlayAnchor anchor = OverlayAnchor::Center;
+    // Gap in DIPs between the clock and the monitor edges for corner anchors.
+    int margin = 24;
+    // Rasterize on a background thread and only upload on the UI thread.
+    // Only used by the Gdi backend.
+    bool useRenderThread = false;
+    OverlayBackend backend = OverlayBackend::Gdi;
+    SecondsDisplay seconds = SecondsDisplay::None;
+    // Longest acceptable redraw plus upload of one sweep frame.
+    double sweepBudgetMs = 4.0;
+    RenderQuality quality = RenderQuality::High;
+    FadeCurve fadeCurve = FadeCurve::Linear;
+    double fadeDurationMs = 3000.0;
+    // Let the owner park the hidden window in the ResourcePool after the
+    // fade instead of destroying it, so the next show can reuse it.
+    bool reuseWindow = true;
+
+    bool operator==(const OverlayOptions&) const = default;
+};
@@ -0,0 +1,34 @@
+#pragma once
+#include "framework.h"
+#include "OverlayOptions.h"
+
+// A way of getting the clock onto the overlay window. OverlayWindow picks one
+// from OverlayOptions::backend before creating its window, because the
+// renderer decides some of the window's extended styles.
+class IOverlayRenderer
+{
+public:
+    // Posted to the overlay window by renderers that finish frames on
+    // another thread; the window answers by calling OnFrameReady(). wParam
+    // is the rasterization time in microseconds, lParam the RenderQuality
+    // the frame was drawn at.
+    static constexpr UINT WM_FRAME_READY = WM_USER + 3;
+
+    virtual ~IOverlayRenderer() = default;
+
+    // Extra extended styles for CreateWindowExW.
+    virtual DWORD GetWindowExStyle() const = 0;
+    // Creates everything that does not depend on the window.
+    virtual bool Initialize(int size) = 0;
+    // Binds to the freshly created window at its final position.
+    virtual bool Attach(HWND hWnd, POINT position) = 0;
+
+    // Draws a new frame for `time`. It becomes visible on the next Present.
+    // `quality` is never Auto.
+    virtual void Render(const SYSTEMTIME& time, RenderQuality quality) = 0;
+    // Puts the latest frame on screen at the given constant alpha.
+    virtual void Present(BYTE alpha) = 0;
+    // Changes only the constant alpha of what is already on screen.
+    virtual void SetAlpha(BYTE alpha) = 0;
+    virtual void OnFrameReady(BYTE alpha) { Present(alpha); }
+};
@@ -0,0 +1,288 @@
+#include "OverlayStats.h"
+#include <TraceLoggingProvider.h>
+#include <psapi.h>
+#include <algorithm>
+#include <cstdio>
+#pragma comment(lib, "psapi.lib")
+
+// {6F0B5B8E-3C59-4E0D-9A43-2A4C1E7D5F21}
+TRACELOGGING_DEFINE_PROVIDER(
+    g_overlayTraceProvider,
+    "PointerEventsNone.Overlay",
+    (0x6f0b5b8e, 0x3c59, 0x4e0d, 0x9a, 0x43, 0x2a, 0x4c, 0x1e, 0x7d, 0x5f, 0x21));
+
+static double GetQpcTicksPerMs()
+{
+    static const double s_ticksPerMs = []
+    {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        return frequency.QuadPart / 1000.0;
+    }();
+    return s_ticksPerMs;
+}
+
+OverlayStats::OverlayStats()
+    : m_stages()
+    , m_fadeFrames(0)
+    , m_lateFrames(0)
+    , m_droppedFrames(0)
+    , m_hudEnabled(false)
+{
+    InitializeSRWLock(&m_lock);
+    for (double& startupMs : m_startupMs)
+    {
+        startupMs = -1.0;
+    }
+    TraceLoggingRegister(g_overlayTraceProvider);
+}
+
+OverlayStats::~OverlayStats()
+{
+    TraceLoggingUnregister(g_overlayTraceProvider);
+}
+
+OverlayStats& OverlayStats::Shared()
+{
+    static OverlayStats s_stats;
+    return s_stats;
+}
+
+const wchar_t* OverlayStats::GetStageName(RenderStage stage)
+{
+    switch (stage)
+    {
+    case RenderStage::Face:
+        return L"Face";
+    case RenderStage::Mask:
+        return L"Mask";
+    case RenderStage::Rasterize:
+        return L"Rasterize";
+    case RenderStage::Upload:
+        return L"Upload";
+    case RenderStage::AlphaUpdate:
+        return L"AlphaUpdate";
+    default:
+        return L"?";
+    }
+}
+
+const wchar_t* OverlayStats::GetStartupPhaseName(StartupPhase phase)
+{
+    switch (phase)
+    {
+    case StartupPhase::FirstPaint:
+        return L"FirstPaint";
+    case StartupPhase::RendererReady:
+        return L"RendererReady";
+    default:
+        return L"?";
+    }
+}
+
+// Process creation time comes from the kernel, so this includes loader and
+// CRT start-up that happen before wWinMain.
+double OverlayStats::GetMsSinceProcessStart()
+{
+    FILETIME creation;
+    FILETIME exitTime;
+    FILETIME kernel;
+    FILETIME user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exitTime, &kernel, &user))
+        return 0.0;
+
+    FILETIME now;
+    GetSystemTimePreciseAsFileTime(&now);
+
+    ULARGE_INTEGER start = { { creation.dwLowDateTime, creation.dwHighDateTime } };
+    ULARGE_INTEGER current = { { now.dwLowDateTime, now.dwHighDateTime } };
+    // FILETIME counts 100 ns units.
+    return (current.QuadPart - start.QuadPart) / 10000.0;
+}
+
+double OverlayStats::GetTimestampMs()
+{
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return now.QuadPart / GetQpcTicksPerMs();
+}
+
+void OverlayStats::RecordStartupPhase(StartupPhase phase)
+{
+    size_t index = static_cast<size_t>(phase);
+    if (index >= static_cast<size_t>(StartupPhase::Count))
+        return;
+
+    double ms = GetMsSinceProcessStart();
+    AcquireSRWLockExclusive(&m_lock);
+    bool first = m_startupMs[index] < 0.0;
+    if (first)
+    {
+        m_startupMs[index] = ms;
+    }
+    ReleaseSRWLockExclusive(&m_lock);
+
+    if (first)
+    {
+        TraceLoggingWrite(g_overlayTraceProvider, "Startup",
+            TraceLoggingWideString(GetStartupPhaseName(phase), "Phase"),
+            TraceLoggingFloat64(ms, "MsSinceProcessStart"));
+    }
+}
+
+void OverlayStats::RecordStage(RenderStage stage, double ms)
+{
+    size_t index = static_cast<size_t>(stage);
+    if (index >= static_cast<size_t>(RenderStage::Count))
+        return;
+
+    AcquireSRWLockExclusive(&m_lock);
+    StageSamples& stageSamples = m_stages[index];
+    stageSamples.samples[stageSamples.next] = static_cast<float>(ms);
+    stageSamples.next = (stageSamples.next + 1) % SAMPLE_CAPACITY;
+    stageSamples.count = min(stageSamples.count + 1, SAMPLE_CAPACITY);
+    ReleaseSRWLockExclusive(&m_lock);
+
+    TraceLoggingWrite(g_overlayTraceProvider, "StageTiming",
+        TraceLoggingWideString(GetStageName(stage), "Stage"),
+        TraceLoggingFloat64(ms, "DurationMs"));
+}
+
+void OverlayStats::RecordFadeFrame(double intervalMs)
+{
+    AcquireSRWLockExclusive(&m_lock);
+    ++m_fadeFrames;
+    if (intervalMs > LATE_FRAME_MS)
+    {
+        ++m_lateFrames;
+        m_droppedFrames += static_cast<UINT64>(intervalMs / TARGET_FRAME_MS) - 1;
+    }
+    ReleaseSRWLockExclusive(&m_lock);
+}
+
+void OverlayStats::ReportFadeFinished(double durationMs, int clockSize)
+{
+    OverlayStatsSnapshot snapshot = GetSnapshot();
+    TraceLoggingWrite(g_overlayTraceProvider, "FadeFinished",
+        TraceLoggingFloat64(durationMs, "DurationMs"),
+        TraceLoggingInt32(clockSize, "ClockSize"),
+        TraceLoggingUInt64(snapshot.fadeFrames, "FadeFrames"),
+        TraceLoggingUInt64(snapshot.lateFrames, "LateFrames"),
+        TraceLoggingUInt64(snapshot.droppedFrames, "DroppedFrames"),
+        TraceLoggingUInt32(snapshot.gdiObjects, "GdiObjects"),
+        TraceLoggingUInt32(snapshot.userObjects, "UserObjects"),
+        TraceLoggingUInt64(snapshot.privateBytes, "PrivateBytes"));
+}
+
+void OverlayStats::Reset()
+{
+    AcquireSRWLockExclusive(&m_lock);
+    for (StageSamples& stageSamples : m_stages)
+    {
+        stageSamples.next = 0;
+        stageSamples.count = 0;
+    }
+    m_fadeFrames = 0;
+    m_lateFrames = 0;
+    m_droppedFrames = 0;
+    ReleaseSRWLockExclusive(&m_lock);
+}
+
+OverlayStatsSnapshot OverlayStats::GetSnapshot() const
+{
+    OverlayStatsSnapshot snapshot = {};
+    float sorted[SAMPLE_CAPACITY];
+
+    AcquireSRWLockShared(&m_lock);
+    for (size_t i = 0; i < static_cast<size_t>(RenderStage::Count); ++i)
+    {
+        const StageSamples& stageSamples = m_stages[i];
+        StageSummary& summary = snapshot.stages[i];
+        summary.count = stageSamples.count;
+        if (stageSamples.count == 0)
+            continue;
+
+        double total = 0.0;
+        for (size_t j = 0; j < stageSamples.count; ++j)
+        {
+            sorted[j] = stageSamples.samples[j];
+            total += sorted[j];
+        }
+
+        size_t p99Index = (stageSamples.count * 99) / 100;
+        std::nth_element(sorted, sorted + p99Index, sorted + stageSamples.count);
+        summary.p99Ms = sorted[p99Index];
+        summary.minMs = *std::min_element(sorted, sorted + stageSamples.count);
+        summary.avgMs = total / stageSamples.count;
+    }
+    snapshot.fadeFrames = m_fadeFrames;
+    snapshot.lateFrames = m_lateFrames;
+    snapshot.droppedFrames = m_droppedFrames;
+    for (size_t i = 0; i < static_cast<size_t>(StartupPhase::Count); ++i)
+    {
+        snapshot.startupMs[i] = m_startupMs[i];
+    }
+    ReleaseSRWLockShared(&m_lock);
+
+    HANDLE hProcess = GetCurrentProcess();
+    snapshot.gdiObjects = GetGuiResources(hProcess, GR_GDIOBJECTS);
+    snapshot.userObjects = GetGuiResources(hProcess, GR_USEROBJECTS);
+
+    PROCESS_MEMORY_COUNTERS_EX memory = {};
+    memory.cb = sizeof(memory);
+    if (GetProcessMemoryInfo(hProcess, reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&memory), sizeof(memory)))
+    {
+        snapshot.privateBytes = memory.PrivateUsage;
+    }
+
+    return snapshot;
+}
+
+// One line per stage that has samples, then the frame and resource counters.
+std::wstring OverlayStats::FormatSummary() const
+{
+    OverlayStatsSnapshot snapshot = GetSnapshot();
+    std::wstring text;
+    wchar_t line[128];
+
+    for (size_t i = 0; i < static_cast<size_t>(RenderStage::Count); ++i)
+    {
+        const StageSummary& summary = snapshot.stages[i];
+        if (summary.count == 0)
+            continue;
+
+        swprintf_s(line, L"%-11s min %.2f avg %.2f p99 %.2f ms\n",
+            GetStageName(static_cast<RenderStage>(i)), summary.minMs, summary.avgMs, summary.p99Ms);
+        text += line;
+    }
+
+    for (size_t i = 0; i < static_cast<size_t>(StartupPhase::Count); ++i)
+    {
+        if (snapshot.startupMs[i] < 0.0)
+            continue;
+
+        swprintf_s(line, L"%-13s %.0f ms\n", GetStartupPhaseName(static_cast<StartupPhase>(i)), snapshot.startupMs[i]);
+        text += line;
+    }
+
+    swprintf_s(line, L"fade %llu late %llu dropped %llu\n",
+        snapshot.fadeFrames, snapshot.lateFrames, snapshot.droppedFrames);
+    text += line;
+    swprintf_s(line, L"GDI %lu USER %lu private %.1f MB",
+        snapshot.gdiObjects, snapshot.userObjects, snapshot.privateBytes / (1024.0 * 1024.0));
+    text += line;
+    return text;
+}
+
+ScopedStageTimer::ScopedStageTimer(RenderStage stage)
+    : m_stage(stage)
+{
+    QueryPerformanceCounter(&m_start);
+}
+
+ScopedStageTimer::~ScopedStageTimer()
+{
+    LARGE_INTEGER end;
+    QueryPerformanceCounter(&end);
+    OverlayStats::Shared().RecordStage(m_stage, (end.QuadPart - m_start.QuadPart) / GetQpcTicksPerMs());
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include "framework.h"
+#include <string>
+
+// Pipeline stages that are timed, in the order they run.
+enum class RenderStage
+{
+    // Face layer: drawing, masking and premultiplying (once per size).
+    Face,
+    Mask,
+    // Per-frame copy of the face plus the hands.
+    Rasterize,
+    // Full UpdateLayeredWindow (or swap chain Present) with new pixels.
+    Upload,
+    // Alpha-only fade step.
+    AlphaUpdate,
+    Count,
+};
+
+// One-off startup milestones, measured from process creation.
+enum class StartupPhase
+{
+    // The main window finished its first WM_PAINT.
+    FirstPaint,
+    // The overlay renderer (GDI+) is loaded and started.
+    RendererReady,
+    Count,
+};
+
+struct StageSummary
+{
+    size_t count;
+    double minMs;
+    double avgMs;
+    double p99Ms;
+};
+
+struct OverlayStatsSnapshot
+{
+    StageSummary stages[static_cast<size_t>(RenderStage::Count)];
+    UINT64 fadeFrames;
+    UINT64 lateFrames;
+    UINT64 droppedFrames;
+    DWORD gdiObjects;
+    DWORD userObjects;
+    SIZE_T privateBytes;
+    // Negative until the phase has been reached.
+    double startupMs[static_cast<size_t>(StartupPhase::Count)];
+};
+
+// Process-wide timing and resource counters for the overlay pipeline.
+//
+// Each stage keeps its last SAMPLE_CAPACITY durations in a ring buffer, so
+// summaries cover recent frames and recording never allocates. Every sample
+// and every finished fade is also written as a TraceLogging event under the
+// "PointerEventsNone.Overlay" provider. Thread-safe; the render worker
+// records from its own thread.
+class OverlayStats
+{
+private:
+    static constexpr size_t SAMPLE_CAPACITY = 256;
+    // A fade frame later than this after the previous one counts as late;
+    // every whole TARGET_FRAME_MS beyond the first counts as dropped.
+    static constexpr double TARGET_FRAME_MS = 1000.0 / 60.0;
+    static constexpr double LATE_FRAME_MS = TARGET_FRAME_MS * 1.5;
+
+    struct StageSamples
+    {
+        float samples[SAMPLE_CAPACITY];
+        size_t next;
+        size_t count;
+    };
+
+    mutable SRWLOCK m_lock;
+    StageSamples m_stages[static_cast<size_t>(RenderStage::Count)];
+    UINT64 m_fadeFrames;
+    UINT64 m_lateFrames;
+    UINT64 m_droppedFrames;
+    double m_startupMs[static_cast<size_t>(StartupPhase::Count)];
+    bool m_hudEnabled;
+
+    OverlayStats();
+
+public:
+    ~OverlayStats();
+    OverlayStats(const OverlayStats&) = delete;
+    OverlayStats& operator=(const OverlayStats&) = delete;
+
+    static OverlayStats& Shared();
+    static const wchar_t* GetStageName(RenderStage stage);
+    static const wchar_t* GetStartupPhaseName(StartupPhase phase);
+    static double GetMsSinceProcessStart();
+    // QPC in milliseconds, for timing intervals on any thread.
+    static double GetTimestampMs();
+
+    void RecordStage(RenderStage stage, double ms);
+    // `intervalMs` is the time since the previous frame of the same fade.
+    void RecordFadeFrame(double intervalMs);
+    void ReportFadeFinished(double durationMs, int clockSize);
+    // Only the first call per phase counts.
+    void RecordStartupPhase(StartupPhase phase);
+    void Reset();
+
+    OverlayStatsSnapshot GetSnapshot() const;
+    std::wstring FormatSummary() const;
+
+    // Draws FormatSummary() onto the overlay on every redraw.
+    void SetHudEnabled(bool enabled) { m_hudEnabled = enabled; }
+    bool IsHudEnabled() const { return m_hudEnabled; }
+};
+
+// Times one stage from construction to destruction with QPC.
+class ScopedStageTimer
+{
+private:
+    RenderStage m_stage;
+    LARGE_INTEGER m_start;
+
+public:
+    explicit ScopedStageTimer(RenderStage stage);
+    ~ScopedStageTimer();
+    ScopedStageTimer(const ScopedStageTimer&) = delete;
+    ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+};
@@ -1,55 +1,58 @@
 #include "OverlayWindow.h"
-#include <gdiplus.h>
-#pragma comment(lib, "gdiplus.lib")
-
-using namespace Gdiplus;
-
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
+#include "LayeredWindowRenderer.h"
+#include "CompositionRenderer.h"
+#include "ClockContent.h"
+#include "OverlayStats.h"
+#include "GdiPlusRuntime.h"
+#include <shellapi.h>
+#include <shellscalingapi.h>
+#include <wtsapi32.h>
+#pragma comment(lib, "shcore.lib")
+#pragma comment(lib, "wtsapi32.lib")
 
 static const wchar_t* OVERLAY_CLASS_NAME = L"OverlayWindowClass";
+static bool s_classRegistered = false;
 
-OverlayWindow::OverlayWindow(HINSTANCE hInstance)
+OverlayWindow::OverlayWindow(HINSTANCE hInstance, const OverlayOptions& options, HMONITOR hMonitor,
+    std::shared_ptr<const IOverlayContent> content)
     : m_hWnd(nullptr)
     , m_hInstance(hInstance)
-    , m_fadeoutCounter(0)
+    , m_options(options)
+    , m_content(content ? std::move(content) : std::make_shared<ClockContent>(options.seconds))
     , m_currentAlpha(255)
-    , m_screenWidth(0)
-    , m_screenHeight(0)
+    , m_hMonitor(hMonitor ? hMonitor : MonitorFromPoint(POINT{ 0, 0 }, MONITOR_DEFAULTTOPRIMARY))
+    , m_monitorRect()
+    , m_dpi(USER_DEFAULT_SCREEN_DPI)
     , m_clockSize(0)
-    , m_hdcMem(nullptr)
-    , m_hBitmap(nullptr)
-    , m_hOldBitmap(nullptr)
-    , m_pBits(nullptr)
+    , m_position()
+    , m_stateRendered(false)
+    , m_renderedStateKey(0)
+    , m_displayTime()
+    , m_lastFadeFrameMs(0.0)
+    , m_sweeping(false)
+    , m_slowSweepFrames(0)
+    , m_qualityDowngraded(false)
+    , m_hDisplayNotify(nullptr)
+    , m_sessionLocked(false)
+    , m_displayOff(false)
+    , m_suspended(false)
 {
+    m_fadeTable.Build(options.fadeCurve, options.fadeDurationMs);
 }
 
 OverlayWindow::~OverlayWindow()
 {
-    if (m_hdcMem)
-    {
-        if (m_hOldBitmap)
-        {
-            SelectObject(m_hdcMem, m_hOldBitmap);
-        }
-        if (m_hBitmap)
-        {
-            DeleteObject(m_hBitmap);
-        }
-        DeleteDC(m_hdcMem);
-    }
-    
     if (m_hWnd)
     {
+        // Detach first so WM_NCDESTROY doesn't report back to the owner.
+        SetWindowLongPtr(m_hWnd, GWLP_USERDATA, 0);
+        m_animationClock.Stop();
         DestroyWindow(m_hWnd);
     }
 }
 
 bool OverlayWindow::Create()
 {
-    static bool s_classRegistered = false;
-    
     if (!s_classRegistered)
     {
         WNDCLASSEXW wcex = {};
@@ -69,18 +72,225 @@ bool OverlayWindow::Create()
         s_classRegistered = true;
     }
 
-    m_screenWidth = GetSystemMetrics(SM_CXSCREEN);
-    m_screenHeight = GetSystemMetrics(SM_CYSCREEN);
+    LayoutClock();
+
+    // The composition back-end can fail at either stage; both times the
+    // overlay continues on GDI, with a fresh window because the extended
+    // styles differ.
+    bool created = false;
+    if (m_options.backend == OverlayBackend::Composition)
+    {
+        created = CreateRenderer(OverlayBackend::Composition) && CreateOverlayWindow();
+        if (!created && m_hWnd)
+        {
+            SetWindowLongPtr(m_hWnd, GWLP_USERDATA, 0);
+            DestroyWindow(m_hWnd);
+            m_hWnd = nullptr;
+        }
+    }
+
+    if (!created && !(CreateRenderer(OverlayBackend::Gdi) && CreateOverlayWindow()))
+    {
+        return false;
+    }
+
+    // Without the scheduler, TIMER_ID carries the same due times at timer
+    // resolution.
+    m_clockScheduler.Start(m_hWnd, WM_CLOCK_TICK);
+    RegisterPresenceNotifications();
+
+    UpdateClockState();
+    CreateClockBitmap();
     
-    int minDimension = min(m_screenWidth, m_screenHeight);
-    m_clockSize = static_cast<int>(minDimension * 0.8);
+    return true;
+}
+
+void OverlayWindow::Show()
+{
+    // A reused window keeps its last frame. It is handed back to the
+    // renderer anyway, which redraws it if the content changed or the frame
+    // was drawn at a lower tier near the end of the last fade.
+    m_currentAlpha = 255;
+    m_sweeping = m_content->IsAnimated() && !IsOnBatteryPower();
+    m_slowSweepFrames = 0;
+    m_qualityDowngraded = false;
+    m_suspended = m_sessionLocked || m_displayOff || IsFullScreenAppRunning();
+
+    // Showing a window that is still fading restarts its fade.
+    m_lastFadeFrameMs = 0.0;
+    m_animationClock.Restart();
+
+    // Nobody can see a suspended overlay, so it is shown without being drawn
+    // and catches up in Resume().
+    if (!m_suspended)
+    {
+        UpdateClockState();
+        CreateClockBitmap();
+    }
+
+    ShowWindow(m_hWnd, SW_SHOW);
+    UpdateWindow(m_hWnd);
+    if (m_suspended)
+    {
+        Suspend();
+        return;
+    }
+
+    KillTimer(m_hWnd, SUSPEND_TIMER_ID);
+    if (OverlayStats::Shared().IsHudEnabled())
+    {
+        SetTimer(m_hWnd, HUD_TIMER_ID, HUD_REFRESH_MS, nullptr);
+    }
+    UpdateWindowDisplay();
+    if (!m_animationClock.IsRunning() && !m_animationClock.Resume(m_hWnd, WM_ANIMATION_FRAME))
+    {
+        SetTimer(m_hWnd, FADEOUT_TIMER_ID, FADEOUT_FALLBACK_INTERVAL_MS, nullptr);
+    }
+}
+
+// Uploads the first frame while the window stays hidden and stops the minute
+// timer, so a parked window costs nothing until Show() brings the hands up to
+// date and makes it visible.
+void OverlayWindow::Prewarm()
+{
+    CancelClockUpdate();
+    m_currentAlpha = 0;
+    UpdateWindowDisplay();
+}
+
+// Only needed when the class belongs to a DLL that may be unloaded, and only
+// once every overlay window is destroyed.
+void OverlayWindow::UnregisterWindowClass(HINSTANCE hInstance)
+{
+    if (s_classRegistered && UnregisterClassW(OVERLAY_CLASS_NAME, hInstance))
+    {
+        s_classRegistered = false;
+    }
+}
+
+void OverlayWindow::Hide()
+{
+    if (IsVisible())
+    {
+        FinishFade();
+    }
+}
+
+bool OverlayWindow::IsVisible() const
+{
+    return m_hWnd && IsWindowVisible(m_hWnd);
+}
+
+void OverlayWindow::SetFinishedCallback(FinishedCallback callback)
+{
+    m_onFinished = std::move(callback);
+}
+
+// A parked window can be shown again if it was laid out for the same options
+// and content on the same monitor, and that monitor still has the same rect
+// and scale.
+bool OverlayWindow::CanReuse(const OverlayOptions& options, const IOverlayContent& content, HMONITOR hMonitor) const
+{
+    if (!m_hWnd || m_options != options || m_hMonitor != hMonitor
+        || wcscmp(m_content->GetContentId(), content.GetContentId()) != 0)
+        return false;
+
+    RECT monitorRect;
+    UINT dpi;
+    return GetMonitorLayout(m_hMonitor, monitorRect, dpi)
+        && EqualRect(&monitorRect, &m_monitorRect)
+        && dpi == m_dpi;
+}
 
+// The process is per-monitor DPI aware, so the rect is in physical pixels of
+// that monitor and the clock is rasterized at its native resolution.
+bool OverlayWindow::GetMonitorLayout(HMONITOR hMonitor, RECT& monitorRect, UINT& dpi)
+{
+    MONITORINFO info = {};
+    info.cbSize = sizeof(info);
+    if (!GetMonitorInfoW(hMonitor, &info))
+        return false;
+
+    UINT dpiX = USER_DEFAULT_SCREEN_DPI;
+    UINT dpiY = USER_DEFAULT_SCREEN_DPI;
+    if (FAILED(GetDpiForMonitor(hMonitor, MDT_EFFECTIVE_DPI, &dpiX, &dpiY)))
+    {
+        dpiX = USER_DEFAULT_SCREEN_DPI;
+    }
+
+    monitorRect = info.rcMonitor;
+    dpi = dpiX;
+    return true;
+}
+
+// Resolves the clock size and its top-left corner from m_options. The window
+// is created at exactly this rect so DWM never composites more than the clock.
+void OverlayWindow::LayoutClock()
+{
+    if (!GetMonitorLayout(m_hMonitor, m_monitorRect, m_dpi))
+    {
+        SetRect(&m_monitorRect, 0, 0, GetSystemMetrics(SM_CXSCREEN), GetSystemMetrics(SM_CYSCREEN));
+        m_dpi = USER_DEFAULT_SCREEN_DPI;
+    }
+
+    int monitorWidth = m_monitorRect.right - m_monitorRect.left;
+    int monitorHeight = m_monitorRect.bottom - m_monitorRect.top;
+
+    float sizeRatio = max(0.0f, min(1.0f, m_options.sizeRatio));
+    int minDimension = min(monitorWidth, monitorHeight);
+    m_clockSize = max(MIN_CLOCK_SIZE, static_cast<int>(minDimension * sizeRatio));
+
+    int margin = MulDiv(m_options.margin, m_dpi, USER_DEFAULT_SCREEN_DPI);
+    int left = m_monitorRect.left + margin;
+    int top = m_monitorRect.top + margin;
+    int right = m_monitorRect.right - m_clockSize - margin;
+    int bottom = m_monitorRect.bottom - m_clockSize - margin;
+
+    switch (m_options.anchor)
+    {
+    case OverlayAnchor::TopLeft:
+        m_position = { left, top };
+        break;
+    case OverlayAnchor::TopRight:
+        m_position = { right, top };
+        break;
+    case OverlayAnchor::BottomLeft:
+        m_position = { left, bottom };
+        break;
+    case OverlayAnchor::BottomRight:
+        m_position = { right, bottom };
+        break;
+    default:
+        m_position = { m_monitorRect.left + (monitorWidth - m_clockSize) / 2, m_monitorRect.top + (monitorHeight - m_clockSize) / 2 };
+        break;
+    }
+}
+
+bool OverlayWindow::CreateRenderer(OverlayBackend backend)
+{
+    if (backend == OverlayBackend::Composition)
+    {
+        m_renderer = std::make_unique<CompositionRenderer>(m_content);
+    }
+    else
+    {
+        if (!GdiPlusRuntime::Shared().EnsureStarted())
+            return false;
+
+        m_renderer = std::make_unique<LayeredWindowRenderer>(m_options.useRenderThread, m_content);
+    }
+
+    return m_renderer->Initialize(m_clockSize);
+}
+
+bool OverlayWindow::CreateOverlayWindow()
+{
     m_hWnd = CreateWindowExW(
-        WS_EX_TOPMOST | WS_EX_LAYERED | WS_EX_TOOLWINDOW,
+        WS_EX_TOPMOST | WS_EX_LAYERED | WS_EX_TOOLWINDOW | m_renderer->GetWindowExStyle(),
         OVERLAY_CLASS_NAME,
         L"Overlay",
         WS_POPUP,
-        0, 0, m_screenWidth, m_screenHeight,
+        m_position.x, m_position.y, m_clockSize, m_clockSize,
         nullptr,
         nullptr,
         m_hInstance,
@@ -93,16 +303,7 @@ bool OverlayWindow::Create()
     }
 
     MakeWindowClickThrough();
-    CreateClockBitmap();
-    
-    return true;
-}
-
-void OverlayWindow::Show()
-{
-    ShowWindow(m_hWnd, SW_SHOW);
-    UpdateWindow(m_hWnd);
-    UpdateWindowDisplay();
+    return m_renderer->Attach(m_hWnd, m_position);
 }
 
 void OverlayWindow::MakeWindowClickThrough()
@@ -139,9 +340,6 @@ LRESULT OverlayWindow::WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lP
     switch (message)
     {
     case WM_CREATE:
-        SetTimer(hWnd, TIMER_ID, 1000, nullptr);
-        SetTimer(hWnd, FADEOUT_TIMER_ID, 30, nullptr);
-        m_fadeoutCounter = 0;
         m_currentAlpha = 255;
         return 0;
 
@@ -156,201 +354,402 @@ LRESULT OverlayWindow::WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lP
     case WM_TIMER:
         if (wParam == TIMER_ID)
         {
-            CreateClockBitmap();
-            UpdateWindowDisplay();
+            OnClockTick();
         }
         else if (wParam == FADEOUT_TIMER_ID)
         {
-            m_fadeoutCounter++;
-            if (m_fadeoutCounter >= 100)
-            {
-                DestroyWindow(hWnd);
-            }
-            else
+            AdvanceFade();
+        }
+        else if (wParam == SUSPEND_TIMER_ID)
+        {
+            OnSuspendTimer();
+        }
+        else if (wParam == HUD_TIMER_ID)
+        {
+            OnHudTimer();
+        }
+        return 0;
+
+    case WM_CLOCK_TICK:
+        OnClockTick();
+        return 0;
+
+    case WM_WTSSESSION_CHANGE:
+        if (wParam == WTS_SESSION_LOCK || wParam == WTS_SESSION_UNLOCK)
+        {
+            m_sessionLocked = wParam == WTS_SESSION_LOCK;
+            UpdateSuspension();
+        }
+        return 0;
+
+    // Dimmed (2) still shows the overlay; only off (0) suspends it.
+    case WM_POWERBROADCAST:
+        if (wParam == PBT_POWERSETTINGCHANGE)
+        {
+            const POWERBROADCAST_SETTING* pSetting = reinterpret_cast<const POWERBROADCAST_SETTING*>(lParam);
+            if (IsEqualGUID(pSetting->PowerSetting, GUID_CONSOLE_DISPLAY_STATE) && pSetting->DataLength >= sizeof(DWORD))
             {
-                m_currentAlpha = static_cast<BYTE>(255 * (100 - m_fadeoutCounter) / 100);
-                UpdateWindowDisplay();
+                m_displayOff = *reinterpret_cast<const DWORD*>(pSetting->Data) == 0;
+                UpdateSuspension();
             }
         }
+        return TRUE;
+
+    // Sent for changes of the system time and of the time zone; either can
+    // move the next visible change, so re-read the time and re-arm.
+    case WM_TIMECHANGE:
+        OnClockTick();
+        return 0;
+
+    case WM_ANIMATION_FRAME:
+        m_animationClock.OnFrame();
+        if (m_animationClock.IsRunning())
+        {
+            AdvanceFade();
+        }
+        return 0;
+
+    // The overlay belongs to one monitor and is laid out for it; don't let
+    // Windows move or resize it to a suggested rect.
+    case WM_DPICHANGED:
+        return 0;
+
+    case IOverlayRenderer::WM_FRAME_READY:
+        CheckRenderBudget(static_cast<RenderQuality>(lParam), wParam / 1000.0);
+        if (m_renderer)
+        {
+            m_renderer->OnFrameReady(m_currentAlpha);
+        }
         return 0;
 
     case WM_DESTROY:
+        m_animationClock.Stop();
+        m_clockScheduler.Stop();
+        UnregisterPresenceNotifications();
+        m_renderer.reset();
         KillTimer(hWnd, TIMER_ID);
         KillTimer(hWnd, FADEOUT_TIMER_ID);
-        PostMessage(hWnd, WM_CLEANUP, 0, 0);
+        KillTimer(hWnd, SUSPEND_TIMER_ID);
+        KillTimer(hWnd, HUD_TIMER_ID);
         return 0;
-        
-    case WM_CLEANUP:
-        delete this;
+
+    // Both notifications are the last thing this instance does, because the
+    // owner may delete it (and the callback) from inside the call.
+    // A window that was shown again before this arrived is not finished.
+    case WM_FADE_FINISHED:
+        if (!IsWindowVisible(hWnd) && m_onFinished)
+        {
+            FinishedCallback callback = m_onFinished;
+            callback(this);
+        }
         return 0;
+
+    case WM_NCDESTROY:
+        {
+            LRESULT result = DefWindowProc(hWnd, message, wParam, lParam);
+            m_hWnd = nullptr;
+            if (m_onFinished)
+            {
+                FinishedCallback callback = m_onFinished;
+                callback(this);
+            }
+            return result;
+        }
     }
     return DefWindowProc(hWnd, message, wParam, lParam);
 }
 
-void OverlayWindow::CreateClockBitmap()
+// The fade is a function of wall-clock time since Show(), so its length does
+// not depend on how many frames were actually delivered. Frames that land on
+// the same table entry as the last one are not uploaded; long fades have
+// many of them.
+void OverlayWindow::AdvanceFade()
 {
-    HDC hdcScreen = GetDC(nullptr);
-    if (!hdcScreen)
+    double elapsed = m_animationClock.GetElapsedMs();
+    OverlayStats::Shared().RecordFadeFrame(elapsed - m_lastFadeFrameMs);
+    m_lastFadeFrameMs = elapsed;
+
+    if (elapsed >= m_fadeTable.GetDurationMs())
+    {
+        OverlayStats::Shared().ReportFadeFinished(elapsed, m_clockSize);
+        FinishFade();
         return;
-    
-    if (!m_hdcMem)
+    }
+
+    BYTE alpha = m_fadeTable.GetAlpha(elapsed);
+    bool alphaChanged = alpha != m_currentAlpha;
+    m_currentAlpha = alpha;
+    bool reuseFrame = m_options.quality == RenderQuality::Auto && m_currentAlpha < REUSE_FRAME_ALPHA;
+    if (m_sweeping && !reuseFrame && UpdateClockState())
     {
-        m_hdcMem = CreateCompatibleDC(hdcScreen);
-        if (!m_hdcMem)
-        {
-            ReleaseDC(nullptr, hdcScreen);
-            return;
-        }
-        
-        BITMAPINFO bmi = {};
-        bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-        bmi.bmiHeader.biWidth = m_clockSize;
-        bmi.bmiHeader.biHeight = -m_clockSize;
-        bmi.bmiHeader.biPlanes = 1;
-        bmi.bmiHeader.biBitCount = 32;
-        bmi.bmiHeader.biCompression = BI_RGB;
-
-        m_hBitmap = CreateDIBSection(m_hdcMem, &bmi, DIB_RGB_COLORS, (void**)&m_pBits, nullptr, 0);
-        if (!m_hBitmap || !m_pBits)
-        {
-            DeleteDC(m_hdcMem);
-            m_hdcMem = nullptr;
-            ReleaseDC(nullptr, hdcScreen);
-            return;
-        }
-        
-        m_hOldBitmap = (HBITMAP)SelectObject(m_hdcMem, m_hBitmap);
+        RenderSweepFrame();
+        return;
     }
 
-    Graphics graphics(m_hdcMem);
-    graphics.SetSmoothingMode(SmoothingModeAntiAlias);
-    graphics.SetPixelOffsetMode(PixelOffsetModeHighQuality);
-    graphics.SetCompositingQuality(CompositingQualityHighQuality);
-    graphics.SetInterpolationMode(InterpolationModeHighQualityBicubic);
-    graphics.Clear(Color(0, 0, 0, 0));
+    if (alphaChanged)
+    {
+        UpdateWindowAlpha();
+    }
+}
 
-    float centerX = m_clockSize / 2.0f;
-    float centerY = m_clockSize / 2.0f;
-    float diameter = m_clockSize - 4.0f;
-    float margin = 2.0f;
+// Redraws what moved and uploads it together with the new alpha. A sweep
+// that keeps missing its budget settles for the content's timed updates,
+// e.g. a second hand ticking once a second.
+void OverlayWindow::RenderSweepFrame()
+{
+    double start = m_animationClock.GetElapsedMs();
+    CreateClockBitmap();
+    UpdateWindowDisplay();
+    double cost = m_animationClock.GetElapsedMs() - start;
 
-    SolidBrush whiteBrush(Color(255, 255, 255, 255));
-    graphics.FillEllipse(&whiteBrush, margin, margin, diameter, diameter);
+    if (cost <= m_options.sweepBudgetMs)
+    {
+        m_slowSweepFrames = 0;
+    }
+    else if (++m_slowSweepFrames >= SLOW_SWEEP_FRAME_LIMIT)
+    {
+        m_sweeping = false;
+    }
+}
 
-    Pen blackPen(Color(255, 0, 0, 0), 3.0f);
-    blackPen.SetStartCap(LineCapRound);
-    blackPen.SetEndCap(LineCapRound);
-    graphics.DrawEllipse(&blackPen, margin + 1.5f, margin + 1.5f, diameter - 3.0f, diameter - 3.0f);
+// Session and display notifications are per window; registering the display
+// setting delivers its current state right away.
+void OverlayWindow::RegisterPresenceNotifications()
+{
+    WTSRegisterSessionNotification(m_hWnd, NOTIFY_FOR_THIS_SESSION);
+    m_hDisplayNotify = RegisterPowerSettingNotification(m_hWnd, &GUID_CONSOLE_DISPLAY_STATE, DEVICE_NOTIFY_WINDOW_HANDLE);
+}
 
-    SYSTEMTIME st;
-    GetLocalTime(&st);
+void OverlayWindow::UnregisterPresenceNotifications()
+{
+    WTSUnRegisterSessionNotification(m_hWnd);
+    if (m_hDisplayNotify)
+    {
+        UnregisterPowerSettingNotification(m_hDisplayNotify);
+        m_hDisplayNotify = nullptr;
+    }
+}
 
-    double hourAngle = ((st.wHour % 12) + st.wMinute / 60.0) * 30.0;
-    double minuteAngle = st.wMinute * 6.0;
+// DWM doesn't compose other windows over an exclusive full-screen Direct3D
+// app. There is no notification for it, so it is polled.
+bool OverlayWindow::IsFullScreenAppRunning()
+{
+    QUERY_USER_NOTIFICATION_STATE state;
+    return SUCCEEDED(SHQueryUserNotificationState(&state)) && state == QUNS_RUNNING_D3D_FULL_SCREEN;
+}
 
-    double hourRadian = (hourAngle - 90.0) * M_PI / 180.0;
-    float hourLength = (diameter / 2.0f) * 0.5f;
-    float hourEndX = centerX + hourLength * static_cast<float>(cos(hourRadian));
-    float hourEndY = centerY + hourLength * static_cast<float>(sin(hourRadian));
+// Called when a session or display notification arrives. Hidden windows only
+// track the state; Show() applies it.
+void OverlayWindow::UpdateSuspension()
+{
+    bool suspended = m_sessionLocked || m_displayOff || IsFullScreenAppRunning();
+    if (suspended == m_suspended)
+        return;
 
-    Pen hourPen(Color(255, 0, 0, 0), 4.0f);
-    hourPen.SetStartCap(LineCapRound);
-    hourPen.SetEndCap(LineCapRound);
-    graphics.DrawLine(&hourPen, centerX, centerY, hourEndX, hourEndY);
+    m_suspended = suspended;
+    if (!IsWindowVisible(m_hWnd))
+        return;
 
-    double minuteRadian = (minuteAngle - 90.0) * M_PI / 180.0;
-    float minuteLength = (diameter / 2.0f) * 0.7f;
-    float minuteEndX = centerX + minuteLength * static_cast<float>(cos(minuteRadian));
-    float minuteEndY = centerY + minuteLength * static_cast<float>(sin(minuteRadian));
+    if (m_suspended)
+    {
+        Suspend();
+    }
+    else
+    {
+        Resume();
+    }
+}
+
+// Stops every frame and clock wakeup. The fade keeps its wall-clock
+// timeline; SUSPEND_TIMER_ID only fires to end it on time or, for a
+// full-screen app, to poll.
+void OverlayWindow::Suspend()
+{
+    m_animationClock.Stop();
+    KillTimer(m_hWnd, FADEOUT_TIMER_ID);
+    CancelClockUpdate();
+
+    double remaining = m_fadeTable.GetDurationMs() - m_animationClock.GetElapsedMs();
+    UINT delay = static_cast<UINT>(max(0.0, min(remaining, static_cast<double>(FULL_SCREEN_POLL_MS))));
+    SetTimer(m_hWnd, SUSPEND_TIMER_ID, max(delay, static_cast<UINT>(USER_TIMER_MINIMUM)), nullptr);
+}
+
+// Catches up with one redraw at the current fade alpha, then continues the
+// fade where wall-clock time has got to.
+void OverlayWindow::Resume()
+{
+    KillTimer(m_hWnd, SUSPEND_TIMER_ID);
 
-    Pen minutePen(Color(255, 0, 0, 0), 2.0f);
-    minutePen.SetStartCap(LineCapRound);
-    minutePen.SetEndCap(LineCapRound);
-    graphics.DrawLine(&minutePen, centerX, centerY, minuteEndX, minuteEndY);
+    double elapsed = m_animationClock.GetElapsedMs();
+    if (elapsed >= m_fadeTable.GetDurationMs())
+    {
+        FinishFade();
+        return;
+    }
+
+    m_lastFadeFrameMs = elapsed;
+    m_currentAlpha = m_fadeTable.GetAlpha(elapsed);
+    if (UpdateClockState())
+    {
+        CreateClockBitmap();
+    }
+    UpdateWindowDisplay();
 
-    SolidBrush centerBrush(Color(255, 0, 0, 0));
-    graphics.FillEllipse(&centerBrush, centerX - 4.0f, centerY - 4.0f, 8.0f, 8.0f);
+    if (!m_animationClock.Resume(m_hWnd, WM_ANIMATION_FRAME))
+    {
+        SetTimer(m_hWnd, FADEOUT_TIMER_ID, FADEOUT_FALLBACK_INTERVAL_MS, nullptr);
+    }
+}
 
-    ApplyCircularAlphaMask();
+void OverlayWindow::OnSuspendTimer()
+{
+    KillTimer(m_hWnd, SUSPEND_TIMER_ID);
+    UpdateSuspension();
+    if (!m_suspended)
+        return;
 
-    ReleaseDC(nullptr, hdcScreen);
+    if (m_animationClock.GetElapsedMs() >= m_fadeTable.GetDurationMs())
+    {
+        FinishFade();
+        return;
+    }
+    Suspend();
 }
 
-void OverlayWindow::ApplyCircularAlphaMask()
+// A suspended overlay skips the refresh and catches up in Resume().
+void OverlayWindow::OnHudTimer()
 {
-    if (!m_pBits)
+    if (!IsWindowVisible(m_hWnd))
+    {
+        KillTimer(m_hWnd, HUD_TIMER_ID);
         return;
+    }
+    if (m_suspended)
+        return;
+
+    CreateClockBitmap();
+    UpdateWindowDisplay();
+}
+
+// On battery, or with battery saver on, sweeping isn't worth the power.
+bool OverlayWindow::IsOnBatteryPower()
+{
+    SYSTEM_POWER_STATUS status;
+    if (!GetSystemPowerStatus(&status))
+        return false;
 
-    float centerX = m_clockSize / 2.0f;
-    float centerY = m_clockSize / 2.0f;
-    float outerRadius = m_clockSize / 2.0f;
-    float innerRadius = outerRadius - 3.0f;
-    float innerRadiusSquared = innerRadius * innerRadius;
-    float outerRadiusSquared = outerRadius * outerRadius;
+    const BYTE BATTERY_SAVER_ON = 1;
+    return status.ACLineStatus == 0 || (status.SystemStatusFlag & BATTERY_SAVER_ON) != 0;
+}
 
-    for (int y = 0; y < m_clockSize; y++)
+// Stops all timers, hides the window and lets the owner decide what happens
+// next. The notification is posted so the owner never deletes this instance
+// while AdvanceFade is still on the stack.
+void OverlayWindow::FinishFade()
+{
+    m_animationClock.Stop();
+    CancelClockUpdate();
+    KillTimer(m_hWnd, FADEOUT_TIMER_ID);
+    KillTimer(m_hWnd, SUSPEND_TIMER_ID);
+    KillTimer(m_hWnd, HUD_TIMER_ID);
+    ShowWindow(m_hWnd, SW_HIDE);
+
+    PostMessage(m_hWnd, WM_FADE_FINISHED, 0, 0);
+}
+
+// Samples the time and schedules one wakeup at the next instant the content
+// can change at, e.g. the next minute for a clock without a second hand.
+// Unless sweeping, the time is truncated to whole seconds. Returns true when
+// the content's state key differs from the rendered frame, so the bitmap is
+// only rebuilt when something visible moved.
+bool OverlayWindow::UpdateClockState()
+{
+    FILETIME now;
+    SYSTEMTIME st;
+    ClockScheduler::SampleTime(now, st);
+    ScheduleClockUpdate(now, m_content->GetUpdateDelayMs(st));
+
+    if (!m_sweeping)
     {
-        for (int x = 0; x < m_clockSize; x++)
-        {
-            float dx = x + 0.5f - centerX;
-            float dy = y + 0.5f - centerY;
-            float distSquared = dx * dx + dy * dy;
-            
-            int index = (y * m_clockSize + x) * 4;
-            BYTE b = m_pBits[index + 0];
-            BYTE g = m_pBits[index + 1];
-            BYTE r = m_pBits[index + 2];
-            BYTE a = m_pBits[index + 3];
-            
-            if (distSquared >= outerRadiusSquared)
-            {
-                m_pBits[index + 0] = 0;
-                m_pBits[index + 1] = 0;
-                m_pBits[index + 2] = 0;
-                m_pBits[index + 3] = 0;
-            }
-            else if (distSquared >= innerRadiusSquared)
-            {
-                float dist = sqrt(distSquared);
-                float alpha = (outerRadius - dist) / (outerRadius - innerRadius);
-                alpha = max(0.0f, min(1.0f, alpha));
-                
-                BYTE newAlpha = static_cast<BYTE>(a * alpha);
-                m_pBits[index + 0] = static_cast<BYTE>(b * newAlpha / 255);
-                m_pBits[index + 1] = static_cast<BYTE>(g * newAlpha / 255);
-                m_pBits[index + 2] = static_cast<BYTE>(r * newAlpha / 255);
-                m_pBits[index + 3] = newAlpha;
-            }
-            else
-            {
-                m_pBits[index + 0] = static_cast<BYTE>(b * a / 255);
-                m_pBits[index + 1] = static_cast<BYTE>(g * a / 255);
-                m_pBits[index + 2] = static_cast<BYTE>(r * a / 255);
-            }
-        }
+        st.wMilliseconds = 0;
     }
+
+    if (m_stateRendered && !m_content->IsDirty(m_renderedStateKey, st))
+        return false;
+
+    m_stateRendered = true;
+    m_renderedStateKey = m_content->GetStateKey(st);
+    m_displayTime = st;
+    return true;
 }
 
-void OverlayWindow::UpdateWindowDisplay()
+void OverlayWindow::ScheduleClockUpdate(const FILETIME& now, UINT delay)
 {
-    if (!m_hdcMem || !m_hBitmap)
+    if (m_clockScheduler.ArmAt(ClockScheduler::AddMs(now, delay)))
         return;
 
-    HDC hdcScreen = GetDC(nullptr);
-    if (!hdcScreen)
+    SetTimer(m_hWnd, TIMER_ID, max(delay, static_cast<UINT>(USER_TIMER_MINIMUM)), nullptr);
+}
+
+void OverlayWindow::CancelClockUpdate()
+{
+    m_clockScheduler.Cancel();
+    KillTimer(m_hWnd, TIMER_ID);
+}
+
+// A hidden window has nothing to keep up to date; Show() re-samples the time
+// anyway. This also drops a tick that was already posted when the update was
+// cancelled.
+void OverlayWindow::OnClockTick()
+{
+    if (!IsWindowVisible(m_hWnd) || m_suspended)
+    {
+        CancelClockUpdate();
         return;
+    }
 
-    POINT ptSrc = { 0, 0 };
-    POINT ptDest = { (m_screenWidth - m_clockSize) / 2, (m_screenHeight - m_clockSize) / 2 };
-    SIZE sizeWnd = { m_clockSize, m_clockSize };
-    
-    BLENDFUNCTION blend = {};
-    blend.BlendOp = AC_SRC_OVER;
-    blend.BlendFlags = 0;
-    blend.SourceConstantAlpha = m_currentAlpha;
-    blend.AlphaFormat = AC_SRC_ALPHA;
+    if (UpdateClockState())
+    {
+        CreateClockBitmap();
+        UpdateWindowDisplay();
+    }
+}
+
+RenderQuality OverlayWindow::PickRenderQuality() const
+{
+    if (m_options.quality != RenderQuality::Auto)
+        return m_options.quality;
 
-    UpdateLayeredWindow(m_hWnd, hdcScreen, &ptDest, &sizeWnd, m_hdcMem, &ptSrc, 0, &blend, ULW_ALPHA);
+    if (m_currentAlpha < FAST_QUALITY_ALPHA)
+        return RenderQuality::Fast;
 
-    ReleaseDC(nullptr, hdcScreen);
+    return m_qualityDowngraded ? RenderQuality::Balanced : RenderQuality::High;
+}
+
+// With a render thread this only times the request; the worker reports the
+// real rasterization time with WM_FRAME_READY.
+void OverlayWindow::CreateClockBitmap()
+{
+    RenderQuality quality = PickRenderQuality();
+    double start = OverlayStats::GetTimestampMs();
+    m_renderer->Render(m_displayTime, quality);
+    CheckRenderBudget(quality, OverlayStats::GetTimestampMs() - start);
+}
+
+void OverlayWindow::CheckRenderBudget(RenderQuality quality, double renderMs)
+{
+    if (quality == RenderQuality::High && m_options.quality == RenderQuality::Auto && renderMs > HIGH_QUALITY_BUDGET_MS)
+    {
+        m_qualityDowngraded = true;
+    }
+}
+
+void OverlayWindow::UpdateWindowDisplay()
+{
+    m_renderer->Present(m_currentAlpha);
+}
+
+void OverlayWindow::UpdateWindowAlpha()
+{
+    m_renderer->SetAlpha(m_currentAlpha);
 }
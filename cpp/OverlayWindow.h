@@ -1,35 +1,124 @@
 #pragma once
 #include "framework.h"
+#include "OverlayContent.h"
+#include "OverlayRenderer.h"
+#include "OverlayOptions.h"
+#include "AnimationClock.h"
+#include "ClockScheduler.h"
+#include "FadeTable.h"
 #include <cmath>
+#include <functional>
+#include <memory>
 
+// A click-through, topmost overlay that fades out along options.fadeCurve
+// over options.fadeDurationMs.
+//
+// The owner is told through the finished callback once the fade has ended
+// (the window is hidden by then) or the window was destroyed, and decides
+// whether to delete or reuse the instance. OverlayWindow never deletes itself.
 class OverlayWindow
 {
+public:
+    typedef std::function<void(OverlayWindow*)> FinishedCallback;
+
 private:
     HWND m_hWnd;
     HINSTANCE m_hInstance;
     static constexpr int TIMER_ID = 1;
     static constexpr int FADEOUT_TIMER_ID = 2;
-    static constexpr int WM_CLEANUP = WM_USER + 1;
-    int m_fadeoutCounter;
+    // Fires while suspended, to end the fade on time and to poll for a
+    // full-screen app going away.
+    static constexpr int SUSPEND_TIMER_ID = 3;
+    static constexpr UINT FULL_SCREEN_POLL_MS = 1000;
+    // Redraws the stats HUD while it is enabled; its numbers change without
+    // the clock state.
+    static constexpr int HUD_TIMER_ID = 4;
+    static constexpr UINT HUD_REFRESH_MS = 500;
+    // Consecutive over-budget sweep frames before falling back to timed
+    // updates.
+    static constexpr int SLOW_SWEEP_FRAME_LIMIT = 3;
+    static constexpr UINT FADEOUT_FALLBACK_INTERVAL_MS = 30;
+    static constexpr int WM_FADE_FINISHED = WM_USER + 1;
+    static constexpr int WM_ANIMATION_FRAME = WM_USER + 2;
+    static constexpr int WM_CLOCK_TICK = WM_USER + 4;
+    static constexpr int MIN_CLOCK_SIZE = 32;
+    // RenderQuality::Auto: frames below FAST_QUALITY_ALPHA are drawn at Fast,
+    // sweep frames below REUSE_FRAME_ALPHA keep the frame on screen, and a
+    // High frame slower than HIGH_QUALITY_BUDGET_MS drops the rest of the
+    // fade to Balanced.
+    static constexpr BYTE FAST_QUALITY_ALPHA = 64;
+    static constexpr BYTE REUSE_FRAME_ALPHA = 24;
+    static constexpr double HIGH_QUALITY_BUDGET_MS = 8.0;
+    OverlayOptions m_options;
+    std::shared_ptr<const IOverlayContent> m_content;
+    FadeTable m_fadeTable;
     BYTE m_currentAlpha;
-    int m_screenWidth;
-    int m_screenHeight;
+    HMONITOR m_hMonitor;
+    RECT m_monitorRect;
+    UINT m_dpi;
     int m_clockSize;
-    HDC m_hdcMem;
-    HBITMAP m_hBitmap;
-    HBITMAP m_hOldBitmap;
-    BYTE* m_pBits;
+    POINT m_position;
+    std::unique_ptr<IOverlayRenderer> m_renderer;
+    bool m_stateRendered;
+    INT64 m_renderedStateKey;
+    SYSTEMTIME m_displayTime;
+    double m_lastFadeFrameMs;
+    bool m_sweeping;
+    int m_slowSweepFrames;
+    bool m_qualityDowngraded;
+    AnimationClock m_animationClock;
+    ClockScheduler m_clockScheduler;
+    FinishedCallback m_onFinished;
+    HPOWERNOTIFY m_hDisplayNotify;
+    bool m_sessionLocked;
+    bool m_displayOff;
+    bool m_suspended;
 
     static LRESULT CALLBACK WndProcStatic(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
     LRESULT WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
+    static bool GetMonitorLayout(HMONITOR hMonitor, RECT& monitorRect, UINT& dpi);
+    void LayoutClock();
+    bool CreateRenderer(OverlayBackend backend);
+    bool CreateOverlayWindow();
+    bool UpdateClockState();
+    void ScheduleClockUpdate(const FILETIME& now, UINT delay);
+    void CancelClockUpdate();
+    void OnClockTick();
+    RenderQuality PickRenderQuality() const;
     void CreateClockBitmap();
-    void ApplyCircularAlphaMask();
+    void CheckRenderBudget(RenderQuality quality, double renderMs);
     void UpdateWindowDisplay();
+    void UpdateWindowAlpha();
+    void AdvanceFade();
+    void RegisterPresenceNotifications();
+    void UnregisterPresenceNotifications();
+    static bool IsFullScreenAppRunning();
+    void UpdateSuspension();
+    void Suspend();
+    void Resume();
+    void OnSuspendTimer();
+    void OnHudTimer();
+    void RenderSweepFrame();
+    static bool IsOnBatteryPower();
+    void FinishFade();
     void MakeWindowClickThrough();
 
 public:
-    OverlayWindow(HINSTANCE hInstance);
+    // A null monitor means the primary one; null content means the clock
+    // described by `options`.
+    OverlayWindow(HINSTANCE hInstance, const OverlayOptions& options = OverlayOptions(), HMONITOR hMonitor = nullptr,
+        std::shared_ptr<const IOverlayContent> content = nullptr);
     ~OverlayWindow();
     bool Create();
+    static void UnregisterWindowClass(HINSTANCE hInstance);
+    void Prewarm();
     void Show();
+    // Skips the rest of the fade. The finished callback runs as usual.
+    void Hide();
+    bool IsVisible() const;
+    const OverlayOptions& GetOptions() const { return m_options; }
+    const std::shared_ptr<const IOverlayContent>& GetContent() const { return m_content; }
+    HMONITOR GetMonitor() const { return m_hMonitor; }
+    bool CanReuse(const OverlayOptions& options, const IOverlayContent& content, HMONITOR hMonitor) const;
+    void SetFinishedCallback(FinishedCallback callback);
 };
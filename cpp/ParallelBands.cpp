@@ -0,0 +1,58 @@
+#include "ParallelBands.h"
+
+// One band per logical processor, but never thinner than MIN_BAND_ROWS.
+int ParallelBands::GetBandCount(int rows)
+{
+    static const int s_processorCount = max(1, static_cast<int>(GetActiveProcessorCount(ALL_PROCESSOR_GROUPS)));
+
+    if (rows < MIN_PARALLEL_ROWS)
+        return 1;
+
+    return max(1, min(s_processorCount, rows / MIN_BAND_ROWS));
+}
+
+void ParallelBands::Run(int top, int bottom, const BandCallback& callback)
+{
+    int rows = bottom - top;
+    if (rows <= 0)
+        return;
+
+    Job job = { &callback, top, rows, GetBandCount(rows), 0 };
+    PTP_WORK work = job.bandCount > 1 ? CreateThreadpoolWork(WorkCallback, &job, nullptr) : nullptr;
+    if (!work)
+    {
+        callback(top, bottom);
+        return;
+    }
+
+    // Bands are claimed from a shared counter, so the calling thread picks up
+    // whatever the pool hasn't started yet instead of waiting idle.
+    for (int i = 1; i < job.bandCount; ++i)
+    {
+        SubmitThreadpoolWork(work);
+    }
+    RunBands(job);
+    WaitForThreadpoolWorkCallbacks(work, FALSE);
+    CloseThreadpoolWork(work);
+}
+
+void CALLBACK ParallelBands::WorkCallback(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_WORK work)
+{
+    UNREFERENCED_PARAMETER(instance);
+    UNREFERENCED_PARAMETER(work);
+    RunBands(*static_cast<Job*>(context));
+}
+
+void ParallelBands::RunBands(Job& job)
+{
+    for (;;)
+    {
+        int band = InterlockedIncrement(&job.nextBand) - 1;
+        if (band >= job.bandCount)
+            return;
+
+        int bandTop = job.top + MulDiv(job.rows, band, job.bandCount);
+        int bandBottom = job.top + MulDiv(job.rows, band + 1, job.bandCount);
+        (*job.pCallback)(bandTop, bandBottom);
+    }
+}
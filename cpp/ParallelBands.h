@@ -0,0 +1,34 @@
+#pragma once
+#include "framework.h"
+#include <functional>
+
+// Splits a range of rows into horizontal bands and runs a callback on each
+// band concurrently, on the process thread pool plus the calling thread.
+// Small ranges run as one band on the calling thread, where the dispatch
+// would cost more than it saves. Run() returns once every band is done.
+class ParallelBands
+{
+public:
+    // Receives [top, bottom) of one band.
+    typedef std::function<void(int top, int bottom)> BandCallback;
+
+private:
+    static constexpr int MIN_PARALLEL_ROWS = 1024;
+    static constexpr int MIN_BAND_ROWS = 256;
+
+    struct Job
+    {
+        const BandCallback* pCallback;
+        int top;
+        int rows;
+        int bandCount;
+        volatile LONG nextBand;
+    };
+
+    static void CALLBACK WorkCallback(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_WORK work);
+    static void RunBands(Job& job);
+
+public:
+    static int GetBandCount(int rows);
+    static void Run(int top, int bottom, const BandCallback& callback);
+};
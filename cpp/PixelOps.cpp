@@ -0,0 +1,321 @@
+#include "PixelOps.h"
+
+#if defined(_M_X64) || defined(_M_IX86)
+#define PIXELOPS_X86 1
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+typedef void (*PremultiplyProc)(BYTE* pPixels, int count);
+
+static void PremultiplyPixelsScalar(BYTE* pPixels, int count)
+{
+    for (int i = 0; i < count; i++, pPixels += 4)
+    {
+        BYTE a = pPixels[3];
+        if (a == 255)
+            continue;
+
+        pPixels[0] = MulDiv255(pPixels[0], a);
+        pPixels[1] = MulDiv255(pPixels[1], a);
+        pPixels[2] = MulDiv255(pPixels[2], a);
+    }
+}
+
+static void PremultiplyGrayAlphaPixelsScalar(BYTE* pPixels, int count)
+{
+    for (int i = 0; i < count; i++, pPixels += 2)
+    {
+        pPixels[0] = MulDiv255(pPixels[0], pPixels[1]);
+    }
+}
+
+static void ExpandGrayAlphaPixelsScalar(const BYTE* pSource, DWORD* pTarget, int count)
+{
+    for (int i = 0; i < count; i++, pSource += 2)
+    {
+        DWORD gray = pSource[0];
+        *pTarget++ = (static_cast<DWORD>(pSource[1]) << 24) | (gray << 16) | (gray << 8) | gray;
+    }
+}
+
+#ifdef PIXELOPS_X86
+
+// Every lane holds x * a + 128 <= 65153, so the 16-bit multiply is exact and
+// the shifts below reproduce MulDiv255 without leaving unsigned 16-bit range.
+static inline __m128i MulDiv255Epi16(__m128i x, __m128i a)
+{
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(x, a), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+static inline __m128i BroadcastAlphaEpi16(__m128i pixels)
+{
+    __m128i alpha = _mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3));
+    return _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+static void PremultiplyPixelsSse2(BYTE* pPixels, int count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4, pPixels += 16)
+    {
+        __m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pPixels));
+        __m128i lo = _mm_unpacklo_epi8(src, zero);
+        __m128i hi = _mm_unpackhi_epi8(src, zero);
+        lo = MulDiv255Epi16(lo, BroadcastAlphaEpi16(lo));
+        hi = MulDiv255Epi16(hi, BroadcastAlphaEpi16(hi));
+
+        __m128i result = _mm_packus_epi16(lo, hi);
+        result = _mm_or_si128(_mm_andnot_si128(alphaMask, result), _mm_and_si128(alphaMask, src));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pPixels), result);
+    }
+
+    PremultiplyPixelsScalar(pPixels, count - i);
+}
+
+// Read as 16-bit lanes, each gray plus alpha pair is (a << 8) | g: the gray
+// and alpha split out with a mask and a shift.
+static void PremultiplyGrayAlphaPixelsSse2(BYTE* pPixels, int count)
+{
+    const __m128i grayMask = _mm_set1_epi16(0x00FF);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8, pPixels += 16)
+    {
+        __m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pPixels));
+        __m128i gray = MulDiv255Epi16(_mm_and_si128(src, grayMask), _mm_srli_epi16(src, 8));
+        __m128i result = _mm_or_si128(gray, _mm_andnot_si128(grayMask, src));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pPixels), result);
+    }
+
+    PremultiplyGrayAlphaPixelsScalar(pPixels, count - i);
+}
+
+// A BGRA pixel is the 16-bit words (g << 8) | g and (a << 8) | g, and the
+// second one is the source pair as it is, so interleaving those words with
+// the pairs expands eight pixels per load.
+static void ExpandGrayAlphaPixelsSse2(const BYTE* pSource, DWORD* pTarget, int count)
+{
+    const __m128i grayMask = _mm_set1_epi16(0x00FF);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8, pSource += 16, pTarget += 8)
+    {
+        __m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSource));
+        __m128i gray = _mm_and_si128(src, grayMask);
+        gray = _mm_or_si128(gray, _mm_slli_epi16(gray, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pTarget), _mm_unpacklo_epi16(gray, src));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pTarget + 4), _mm_unpackhi_epi16(gray, src));
+    }
+
+    ExpandGrayAlphaPixelsScalar(pSource, pTarget, count - i);
+}
+
+static inline __m256i MulDiv255Epi16(__m256i x, __m256i a)
+{
+    __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(x, a), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+static inline __m256i BroadcastAlphaEpi16(__m256i pixels)
+{
+    __m256i alpha = _mm256_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3));
+    return _mm256_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+// Unpack and pack both operate within 128-bit lanes, so pixel order is
+// preserved without any cross-lane permutes.
+static void PremultiplyPixelsAvx2(BYTE* pPixels, int count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i alphaMask = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8, pPixels += 32)
+    {
+        __m256i src = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pPixels));
+        __m256i lo = _mm256_unpacklo_epi8(src, zero);
+        __m256i hi = _mm256_unpackhi_epi8(src, zero);
+        lo = MulDiv255Epi16(lo, BroadcastAlphaEpi16(lo));
+        hi = MulDiv255Epi16(hi, BroadcastAlphaEpi16(hi));
+
+        __m256i result = _mm256_packus_epi16(lo, hi);
+        result = _mm256_or_si256(_mm256_andnot_si256(alphaMask, result), _mm256_and_si256(alphaMask, src));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pPixels), result);
+    }
+
+    PremultiplyPixelsSse2(pPixels, count - i);
+}
+
+static void PremultiplyGrayAlphaPixelsAvx2(BYTE* pPixels, int count)
+{
+    const __m256i grayMask = _mm256_set1_epi16(0x00FF);
+
+    int i = 0;
+    for (; i + 16 <= count; i += 16, pPixels += 32)
+    {
+        __m256i src = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pPixels));
+        __m256i gray = MulDiv255Epi16(_mm256_and_si256(src, grayMask), _mm256_srli_epi16(src, 8));
+        __m256i result = _mm256_or_si256(gray, _mm256_andnot_si256(grayMask, src));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pPixels), result);
+    }
+
+    PremultiplyGrayAlphaPixelsSse2(pPixels, count - i);
+}
+
+// The unpacks stay within 128-bit lanes, leaving pixels 0-3 and 8-11 in one
+// register and 4-7 and 12-15 in the other; one permute each restores order.
+static void ExpandGrayAlphaPixelsAvx2(const BYTE* pSource, DWORD* pTarget, int count)
+{
+    const __m256i grayMask = _mm256_set1_epi16(0x00FF);
+
+    int i = 0;
+    for (; i + 16 <= count; i += 16, pSource += 32, pTarget += 16)
+    {
+        __m256i src = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pSource));
+        __m256i gray = _mm256_and_si256(src, grayMask);
+        gray = _mm256_or_si256(gray, _mm256_slli_epi16(gray, 8));
+        __m256i lo = _mm256_unpacklo_epi16(gray, src);
+        __m256i hi = _mm256_unpackhi_epi16(gray, src);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pTarget), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pTarget + 8), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+
+    ExpandGrayAlphaPixelsSse2(pSource, pTarget, count - i);
+}
+
+static bool IsAvx2Available()
+{
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+
+    // AVX needs both CPU support and the OS saving the YMM state.
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+        return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+}
+
+#endif
+
+bool IsPixelKernelSupported(PixelKernel kernel)
+{
+    switch (kernel)
+    {
+    case PixelKernel::Scalar:
+        return true;
+#ifdef PIXELOPS_X86
+    case PixelKernel::Sse2:
+        return IsProcessorFeaturePresent(PF_XMMI64_INSTRUCTIONS_AVAILABLE) != FALSE;
+    case PixelKernel::Avx2:
+        {
+            static const bool s_avx2 = IsAvx2Available();
+            return s_avx2;
+        }
+#endif
+    default:
+        return false;
+    }
+}
+
+static PixelKernel SelectPixelKernel()
+{
+    if (IsPixelKernelSupported(PixelKernel::Avx2))
+        return PixelKernel::Avx2;
+    if (IsPixelKernelSupported(PixelKernel::Sse2))
+        return PixelKernel::Sse2;
+    return PixelKernel::Scalar;
+}
+
+static PixelKernel s_kernel = SelectPixelKernel();
+
+PixelKernel GetPixelKernel()
+{
+    return s_kernel;
+}
+
+bool SetPixelKernel(PixelKernel kernel)
+{
+    if (!IsPixelKernelSupported(kernel))
+        return false;
+
+    s_kernel = kernel;
+    return true;
+}
+
+const char* GetPixelKernelName(PixelKernel kernel)
+{
+    switch (kernel)
+    {
+    case PixelKernel::Sse2:
+        return "sse2";
+    case PixelKernel::Avx2:
+        return "avx2";
+    default:
+        return "scalar";
+    }
+}
+
+void PremultiplyPixels(BYTE* pPixels, int count)
+{
+    switch (s_kernel)
+    {
+#ifdef PIXELOPS_X86
+    case PixelKernel::Avx2:
+        PremultiplyPixelsAvx2(pPixels, count);
+        break;
+    case PixelKernel::Sse2:
+        PremultiplyPixelsSse2(pPixels, count);
+        break;
+#endif
+    default:
+        PremultiplyPixelsScalar(pPixels, count);
+        break;
+    }
+}
+
+void PremultiplyGrayAlphaPixels(BYTE* pPixels, int count)
+{
+    switch (s_kernel)
+    {
+#ifdef PIXELOPS_X86
+    case PixelKernel::Avx2:
+        PremultiplyGrayAlphaPixelsAvx2(pPixels, count);
+        break;
+    case PixelKernel::Sse2:
+        PremultiplyGrayAlphaPixelsSse2(pPixels, count);
+        break;
+#endif
+    default:
+        PremultiplyGrayAlphaPixelsScalar(pPixels, count);
+        break;
+    }
+}
+
+void ExpandGrayAlphaPixels(const BYTE* pSource, DWORD* pTarget, int count)
+{
+    switch (s_kernel)
+    {
+#ifdef PIXELOPS_X86
+    case PixelKernel::Avx2:
+        ExpandGrayAlphaPixelsAvx2(pSource, pTarget, count);
+        break;
+    case PixelKernel::Sse2:
+        ExpandGrayAlphaPixelsSse2(pSource, pTarget, count);
+        break;
+#endif
+    default:
+        ExpandGrayAlphaPixelsScalar(pSource, pTarget, count);
+        break;
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "framework.h"
+
+// Rounded x * a / 255 for 8-bit operands. Identical to (x * a + 127) / 255
+// over the whole 0..255 range, without the divide.
+inline BYTE MulDiv255(unsigned int x, unsigned int a)
+{
+    unsigned int t = x * a + 128;
+    return static_cast<BYTE>((t + (t >> 8)) >> 8);
+}
+
+// Implementations behind the functions below. All of them produce bit-identical
+// output; the fastest one the CPU supports is selected when the module is
+// initialized, and SetPixelKernel can override it.
+enum class PixelKernel
+{
+    Scalar,
+    Sse2,
+    Avx2,
+};
+
+PixelKernel GetPixelKernel();
+bool IsPixelKernelSupported(PixelKernel kernel);
+bool SetPixelKernel(PixelKernel kernel);
+// "scalar", "sse2" or "avx2".
+const char* GetPixelKernelName(PixelKernel kernel);
+
+// Premultiplies the colour channels of `count` consecutive BGRA pixels by
+// their own alpha. The alpha channel is left untouched.
+void PremultiplyPixels(BYTE* pPixels, int count);
+
+// The same for `count` gray plus alpha pairs, as kept by GrayAlphaSurface.
+void PremultiplyGrayAlphaPixels(BYTE* pPixels, int count);
+// Widens `count` gray plus alpha pairs into BGRA pixels with B = G = R.
+void ExpandGrayAlphaPixels(const BYTE* pSource, DWORD* pTarget, int count);
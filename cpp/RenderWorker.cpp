@@ -0,0 +1,165 @@
+#include "RenderWorker.h"
+#include "ResourcePool.h"
+#include "OverlayStats.h"
+
+RenderWorker::RenderWorker(LayerRasterizer& rasterizer, std::shared_ptr<const IOverlayContent> content)
+    : m_rasterizer(rasterizer)
+    , m_content(std::move(content))
+    , m_hWndTarget(nullptr)
+    , m_message(0)
+    , m_hThread(nullptr)
+    , m_hWakeEvent(nullptr)
+    , m_running(false)
+    , m_requestedTime(NO_FRAME)
+    , m_requestedQuality(RenderQuality::High)
+    , m_latestIndex(NO_FRAME)
+    , m_inUseIndex(NO_FRAME)
+{
+}
+
+RenderWorker::~RenderWorker()
+{
+    Stop();
+
+    for (auto& buffer : m_buffers)
+    {
+        ResourcePool::Shared().ReleaseSurface(std::move(buffer));
+    }
+
+    if (m_hWakeEvent)
+    {
+        CloseHandle(m_hWakeEvent);
+    }
+}
+
+bool RenderWorker::Start(HWND hWndTarget, UINT message)
+{
+    Stop();
+
+    int size = m_rasterizer.GetSize();
+    for (auto& buffer : m_buffers)
+    {
+        if (!buffer)
+        {
+            buffer = ResourcePool::Shared().AcquireSurface(size, size);
+            if (!buffer)
+                return false;
+        }
+    }
+
+    if (!m_hWakeEvent)
+    {
+        m_hWakeEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        if (!m_hWakeEvent)
+            return false;
+    }
+
+    m_hWndTarget = hWndTarget;
+    m_message = message;
+    m_requestedTime = NO_FRAME;
+    m_latestIndex = NO_FRAME;
+    m_inUseIndex = NO_FRAME;
+    m_running = true;
+
+    m_hThread = CreateThread(nullptr, 0, ThreadProc, this, 0, nullptr);
+    if (!m_hThread)
+    {
+        m_running = false;
+        return false;
+    }
+
+    return true;
+}
+
+void RenderWorker::Stop()
+{
+    if (!m_hThread)
+        return;
+
+    m_running = false;
+    SetEvent(m_hWakeEvent);
+    WaitForSingleObject(m_hThread, INFINITE);
+    CloseHandle(m_hThread);
+    m_hThread = nullptr;
+}
+
+// The quality is published first, so the frame for this time is drawn at
+// this quality or a later request's.
+void RenderWorker::RequestFrame(const SYSTEMTIME& time, RenderQuality quality)
+{
+    int msOfDay = ((time.wHour * 60 + time.wMinute) * 60 + time.wSecond) * 1000 + time.wMilliseconds;
+    m_requestedQuality = quality;
+    m_requestedTime = msOfDay;
+    SetEvent(m_hWakeEvent);
+}
+
+// Marks the latest frame as in use before confirming it is still the latest.
+// Together with the worker publishing before it checks m_inUseIndex, this
+// guarantees the worker never starts drawing into a buffer being uploaded.
+const DibSurface* RenderWorker::AcquireLatestFrame()
+{
+    for (;;)
+    {
+        int index = m_latestIndex;
+        if (index == NO_FRAME)
+            return nullptr;
+
+        m_inUseIndex = index;
+        if (m_latestIndex == index)
+            return m_buffers[index].get();
+
+        m_inUseIndex = NO_FRAME;
+    }
+}
+
+void RenderWorker::ReleaseFrame()
+{
+    m_inUseIndex = NO_FRAME;
+}
+
+DWORD WINAPI RenderWorker::ThreadProc(LPVOID lpParameter)
+{
+    static_cast<RenderWorker*>(lpParameter)->Run();
+    return 0;
+}
+
+void RenderWorker::Run()
+{
+    while (m_running)
+    {
+        WaitForSingleObject(m_hWakeEvent, INFINITE);
+
+        int msOfDay = m_requestedTime.exchange(NO_FRAME);
+        if (m_running && msOfDay != NO_FRAME)
+        {
+            RenderFrame(msOfDay);
+        }
+    }
+}
+
+void RenderWorker::RenderFrame(int msOfDay)
+{
+    int latest = m_latestIndex;
+    int target = (latest == NO_FRAME) ? 0 : 1 - latest;
+
+    // The UI thread only holds a buffer for the duration of one upload.
+    while (m_inUseIndex == target)
+    {
+        SwitchToThread();
+    }
+
+    SYSTEMTIME time = {};
+    time.wMilliseconds = static_cast<WORD>(msOfDay % 1000);
+    time.wSecond = static_cast<WORD>(msOfDay / 1000 % 60);
+    time.wMinute = static_cast<WORD>(msOfDay / 60000 % 60);
+    time.wHour = static_cast<WORD>(msOfDay / 3600000);
+
+    RenderQuality quality = m_requestedQuality;
+    double start = OverlayStats::GetTimestampMs();
+    if (!m_rasterizer.Render(*m_buffers[target], *m_content, time, quality))
+        return;
+
+    WPARAM durationUs = static_cast<WPARAM>((OverlayStats::GetTimestampMs() - start) * 1000.0);
+    m_latestIndex = target;
+    PostMessage(m_hWndTarget, m_message, durationUs, static_cast<LPARAM>(quality));
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "framework.h"
+#include "DibSurface.h"
+#include "LayerRasterizer.h"
+#include "OverlayContent.h"
+#include "OverlayOptions.h"
+#include <atomic>
+#include <memory>
+
+// Renders overlay frames on a background thread into two alternating DIB
+// sections taken from the ResourcePool and posts a message to the target
+// window when one is complete, with the IOverlayRenderer::WM_FRAME_READY
+// parameters.
+// The UI thread brackets each upload with AcquireLatestFrame/ReleaseFrame;
+// the worker never writes into the buffer that is published or in use.
+class RenderWorker
+{
+private:
+    static constexpr int NO_FRAME = -1;
+
+    LayerRasterizer& m_rasterizer;
+    std::shared_ptr<const IOverlayContent> m_content;
+    HWND m_hWndTarget;
+    UINT m_message;
+    std::unique_ptr<DibSurface> m_buffers[2];
+    HANDLE m_hThread;
+    HANDLE m_hWakeEvent;
+    std::atomic<bool> m_running;
+    std::atomic<int> m_requestedTime;
+    std::atomic<RenderQuality> m_requestedQuality;
+    std::atomic<int> m_latestIndex;
+    std::atomic<int> m_inUseIndex;
+
+    static DWORD WINAPI ThreadProc(LPVOID lpParameter);
+    void Run();
+    void RenderFrame(int msOfDay);
+
+public:
+    RenderWorker(LayerRasterizer& rasterizer, std::shared_ptr<const IOverlayContent> content);
+    ~RenderWorker();
+    RenderWorker(const RenderWorker&) = delete;
+    RenderWorker& operator=(const RenderWorker&) = delete;
+
+    bool Start(HWND hWndTarget, UINT message);
+    void Stop();
+    void RequestFrame(const SYSTEMTIME& time, RenderQuality quality);
+    const DibSurface* AcquireLatestFrame();
+    void ReleaseFrame();
+};
@@ -0,0 +1,163 @@
+#include "ResourcePool.h"
+#include "OverlayWindow.h"
+#include <iterator>
+
+ResourcePool::~ResourcePool()
+{
+    Clear();
+}
+
+ResourcePool& ResourcePool::Shared()
+{
+    static ResourcePool s_pool;
+    return s_pool;
+}
+
+std::unique_ptr<DibSurface> ResourcePool::AcquireSurface(int width, int height)
+{
+    for (auto it = m_surfaces.rbegin(); it != m_surfaces.rend(); ++it)
+    {
+        if ((*it)->GetWidth() == width && (*it)->GetHeight() == height)
+        {
+            std::unique_ptr<DibSurface> surface = std::move(*it);
+            m_surfaces.erase(std::next(it).base());
+            return surface;
+        }
+    }
+
+    auto surface = std::make_unique<DibSurface>();
+    if (!surface->Create(width, height))
+        return nullptr;
+
+    return surface;
+}
+
+void ResourcePool::ReleaseSurface(std::unique_ptr<DibSurface> surface)
+{
+    if (!surface || !surface->IsValid())
+        return;
+
+    if (m_surfaces.size() >= MAX_SURFACES)
+    {
+        m_surfaces.erase(m_surfaces.begin());
+    }
+    m_surfaces.push_back(std::move(surface));
+}
+
+std::unique_ptr<LayerRasterizer> ResourcePool::AcquireRasterizer(int size)
+{
+    for (auto it = m_rasterizers.rbegin(); it != m_rasterizers.rend(); ++it)
+    {
+        if ((*it)->GetSize() == size)
+        {
+            std::unique_ptr<LayerRasterizer> rasterizer = std::move(*it);
+            m_rasterizers.erase(std::next(it).base());
+            return rasterizer;
+        }
+    }
+
+    auto rasterizer = std::make_unique<LayerRasterizer>();
+    if (!rasterizer->SetSize(size))
+        return nullptr;
+
+    return rasterizer;
+}
+
+void ResourcePool::ReleaseRasterizer(std::unique_ptr<LayerRasterizer> rasterizer)
+{
+    if (!rasterizer || rasterizer->GetSize() <= 0)
+        return;
+
+    if (m_rasterizers.size() >= MAX_RASTERIZERS)
+    {
+        m_rasterizers.erase(m_rasterizers.begin());
+    }
+    m_rasterizers.push_back(std::move(rasterizer));
+}
+
+std::shared_ptr<SharedOverlayFrame> ResourcePool::AcquireSharedFrame(int size, std::shared_ptr<const IOverlayContent> content)
+{
+    for (auto it = m_sharedFrames.begin(); it != m_sharedFrames.end();)
+    {
+        std::shared_ptr<SharedOverlayFrame> frame = it->lock();
+        if (!frame)
+        {
+            it = m_sharedFrames.erase(it);
+            continue;
+        }
+        if (frame->GetSize() == size && wcscmp(frame->GetContent().GetContentId(), content->GetContentId()) == 0)
+            return frame;
+        ++it;
+    }
+
+    std::unique_ptr<LayerRasterizer> rasterizer = AcquireRasterizer(size);
+    std::unique_ptr<DibSurface> surface = AcquireSurface(size, size);
+    if (!rasterizer || !surface)
+    {
+        ReleaseSurface(std::move(surface));
+        ReleaseRasterizer(std::move(rasterizer));
+        return nullptr;
+    }
+
+    auto frame = std::make_shared<SharedOverlayFrame>(std::move(rasterizer), std::move(surface), std::move(content));
+    m_sharedFrames.push_back(frame);
+    return frame;
+}
+
+bool ResourcePool::ParkWindow(OverlayWindow* pWindow)
+{
+    if (!pWindow || m_parkedWindows.size() >= MAX_PARKED_WINDOWS)
+        return false;
+
+    m_parkedWindows.push_back(pWindow);
+    return true;
+}
+
+OverlayWindow* ResourcePool::TakeWindow(const OverlayOptions& options, const IOverlayContent& content, HMONITOR hMonitor)
+{
+    for (auto it = m_parkedWindows.begin(); it != m_parkedWindows.end(); ++it)
+    {
+        if ((*it)->CanReuse(options, content, hMonitor))
+        {
+            OverlayWindow* pWindow = *it;
+            m_parkedWindows.erase(it);
+            return pWindow;
+        }
+    }
+
+    return nullptr;
+}
+
+void ResourcePool::Clear()
+{
+    // Parked windows hand their surfaces back to the pool as they are
+    // deleted, so they have to go first.
+    std::vector<OverlayWindow*> parkedWindows;
+    parkedWindows.swap(m_parkedWindows);
+    for (OverlayWindow* pWindow : parkedWindows)
+    {
+        delete pWindow;
+    }
+
+    m_sharedFrames.clear();
+    m_rasterizers.clear();
+    m_surfaces.clear();
+}
+
+void ResourcePool::Abandon()
+{
+    m_parkedWindows.clear();
+    m_sharedFrames.clear();
+    for (std::unique_ptr<LayerRasterizer>& rasterizer : m_rasterizers)
+    {
+        LayerRasterizer* pAbandoned = rasterizer.release();
+        UNREFERENCED_PARAMETER(pAbandoned);
+    }
+    m_rasterizers.clear();
+    for (std::unique_ptr<DibSurface>& surface : m_surfaces)
+    {
+        DibSurface* pAbandoned = surface.release();
+        UNREFERENCED_PARAMETER(pAbandoned);
+    }
+    m_surfaces.clear();
+}
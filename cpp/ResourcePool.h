@@ -0,0 +1,59 @@
+#pragma once
+#include "framework.h"
+#include "DibSurface.h"
+#include "LayerRasterizer.h"
+#include "OverlayContent.h"
+#include "OverlayOptions.h"
+#include "SharedOverlayFrame.h"
+#include <memory>
+#include <vector>
+
+class OverlayWindow;
+
+// Process-wide cache of the expensive parts of an overlay: DIB sections,
+// rasterizers with their static layers already rendered, and hidden overlay
+// windows that finished their fade. Showing an overlay again with the same
+// size then allocates nothing. Live overlays of the same size and content also
+// share one SharedOverlayFrame. Used from the UI thread only.
+class ResourcePool
+{
+private:
+    static constexpr size_t MAX_SURFACES = 4;
+    static constexpr size_t MAX_RASTERIZERS = 2;
+    static constexpr size_t MAX_PARKED_WINDOWS = 2;
+
+    std::vector<std::unique_ptr<DibSurface>> m_surfaces;
+    std::vector<std::unique_ptr<LayerRasterizer>> m_rasterizers;
+    std::vector<std::weak_ptr<SharedOverlayFrame>> m_sharedFrames;
+    std::vector<OverlayWindow*> m_parkedWindows;
+
+    ResourcePool() = default;
+
+public:
+    ~ResourcePool();
+    ResourcePool(const ResourcePool&) = delete;
+    ResourcePool& operator=(const ResourcePool&) = delete;
+
+    static ResourcePool& Shared();
+
+    std::unique_ptr<DibSurface> AcquireSurface(int width, int height);
+    void ReleaseSurface(std::unique_ptr<DibSurface> surface);
+
+    std::unique_ptr<LayerRasterizer> AcquireRasterizer(int size);
+    void ReleaseRasterizer(std::unique_ptr<LayerRasterizer> rasterizer);
+
+    // Returns the frame already used by another overlay of this size and
+    // content id, or a new one built from pooled parts.
+    std::shared_ptr<SharedOverlayFrame> AcquireSharedFrame(int size, std::shared_ptr<const IOverlayContent> content);
+
+    // Parked windows are owned by the pool until taken back or cleared.
+    bool ParkWindow(OverlayWindow* pWindow);
+    OverlayWindow* TakeWindow(const OverlayOptions& options, const IOverlayContent& content, HMONITOR hMonitor);
+
+    void Clear();
+    // Forgets everything without destroying it, for a process exiting with
+    // the loader lock held: parked windows can't be destroyed then, and the
+    // DLLs behind their devices may already be detached. The destructor then
+    // has nothing to do.
+    void Abandon();
+};
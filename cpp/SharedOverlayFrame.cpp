@@ -0,0 +1,69 @@
+#include "SharedOverlayFrame.h"
+#include "ResourcePool.h"
+#include "OverlayStats.h"
+
+SharedOverlayFrame::SharedOverlayFrame(std::unique_ptr<LayerRasterizer> rasterizer, std::unique_ptr<DibSurface> surface, std::shared_ptr<const IOverlayContent> content)
+    : m_rasterizer(std::move(rasterizer))
+    , m_surface(std::move(surface))
+    , m_content(std::move(content))
+    , m_rendered(false)
+    , m_stateKey(0)
+    , m_time()
+    , m_quality(RenderQuality::High)
+    , m_version(0)
+    , m_dirty()
+{
+}
+
+SharedOverlayFrame::~SharedOverlayFrame()
+{
+    ResourcePool::Shared().ReleaseSurface(std::move(m_surface));
+    ResourcePool::Shared().ReleaseRasterizer(std::move(m_rasterizer));
+}
+
+bool SharedOverlayFrame::Render(const SYSTEMTIME& time, RenderQuality quality)
+{
+    INT64 stateKey = m_content->GetStateKey(time);
+    // High < Balanced < Fast, so a smaller value is a better tier. The stats
+    // HUD changes without the content's state, so with it on every request
+    // redraws.
+    bool upgrade = m_rendered && quality < m_quality;
+    bool hud = OverlayStats::Shared().IsHudEnabled();
+    if (m_rendered && !upgrade && !hud && !m_content->IsDirty(m_stateKey, time))
+        return true;
+
+    bool rendered;
+    if (!m_rendered || quality != m_quality)
+    {
+        SetRect(&m_dirty, 0, 0, m_surface->GetWidth(), m_surface->GetHeight());
+        rendered = m_rasterizer->Render(*m_surface, *m_content, time, quality);
+    }
+    else
+    {
+        rendered = m_rasterizer->RenderIncremental(*m_surface, *m_content, m_time, time, quality, m_dirty);
+    }
+
+    if (!rendered)
+    {
+        // The surface content is unknown now; start over next time.
+        m_rendered = false;
+        ++m_version;
+        return false;
+    }
+
+    m_rendered = true;
+    m_stateKey = stateKey;
+    m_time = time;
+    m_quality = quality;
+    ++m_version;
+    return true;
+}
+
+bool SharedOverlayFrame::GetDirtyRect(UINT uploadedVersion, RECT& dirty) const
+{
+    if (uploadedVersion + 1 != m_version)
+        return false;
+
+    dirty = m_dirty;
+    return true;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include "framework.h"
+#include "DibSurface.h"
+#include "LayerRasterizer.h"
+#include "OverlayContent.h"
+#include "OverlayOptions.h"
+#include <memory>
+
+// One rasterized frame shared by every overlay showing the same content at
+// the same size, e.g. one per monitor when the monitors have the same
+// resolution and scale. Render() is a no-op when the frame already shows the
+// requested state at the requested quality or better, so N overlays cost
+// one rasterization per update. UI thread only.
+//
+// Each render bumps the version. A consumer that uploaded the previous
+// version only needs to upload GetDirtyRect(); anyone further behind needs
+// the whole surface.
+class SharedOverlayFrame
+{
+private:
+    std::unique_ptr<LayerRasterizer> m_rasterizer;
+    std::unique_ptr<DibSurface> m_surface;
+    std::shared_ptr<const IOverlayContent> m_content;
+    bool m_rendered;
+    INT64 m_stateKey;
+    SYSTEMTIME m_time;
+    RenderQuality m_quality;
+    UINT m_version;
+    RECT m_dirty;
+
+public:
+    SharedOverlayFrame(std::unique_ptr<LayerRasterizer> rasterizer, std::unique_ptr<DibSurface> surface, std::shared_ptr<const IOverlayContent> content);
+    ~SharedOverlayFrame();
+    SharedOverlayFrame(const SharedOverlayFrame&) = delete;
+    SharedOverlayFrame& operator=(const SharedOverlayFrame&) = delete;
+
+    int GetSize() const { return m_rasterizer->GetSize(); }
+    const IOverlayContent& GetContent() const { return *m_content; }
+    const DibSurface& GetSurface() const { return *m_surface; }
+    UINT GetVersion() const { return m_version; }
+    // False when `uploadedVersion` is too old for a partial update.
+    bool GetDirtyRect(UINT uploadedVersion, RECT& dirty) const;
+    // A frame that already shows `time` is kept unless it was drawn at a
+    // lower quality. A change of quality redraws the whole frame, so one
+    // frame never mixes tiers.
+    bool Render(const SYSTEMTIME& time, RenderQuality quality);
+};
@@ -0,0 +1,76 @@
+#include "SingleInstance.h"
+
+SingleInstance::SingleInstance()
+    : m_hMutex(nullptr)
+{
+}
+
+SingleInstance::~SingleInstance()
+{
+    if (m_hMutex)
+    {
+        CloseHandle(m_hMutex);
+    }
+}
+
+// If the mutex can't be created at all, run standalone rather than not at
+// all.
+bool SingleInstance::Acquire()
+{
+    m_hMutex = CreateMutexW(nullptr, FALSE, MUTEX_NAME);
+    if (!m_hMutex)
+        return true;
+
+    if (GetLastError() == ERROR_ALREADY_EXISTS)
+    {
+        CloseHandle(m_hMutex);
+        m_hMutex = nullptr;
+        return false;
+    }
+    return true;
+}
+
+// The resident instance may have just taken the mutex and not created its
+// window yet. It is also allowed to take the foreground, so it can bring its
+// main window up when asked to.
+bool SingleInstance::Forward(const wchar_t* windowClass, const wchar_t* commandLine)
+{
+    HWND hWndResident = nullptr;
+    for (DWORD waited = 0; waited <= FIND_WINDOW_TIMEOUT_MS; waited += FIND_WINDOW_RETRY_MS)
+    {
+        hWndResident = FindWindowW(windowClass, nullptr);
+        if (hWndResident)
+            break;
+        Sleep(FIND_WINDOW_RETRY_MS);
+    }
+    if (!hWndResident)
+        return false;
+
+    DWORD residentProcessId = 0;
+    GetWindowThreadProcessId(hWndResident, &residentProcessId);
+    AllowSetForegroundWindow(residentProcessId);
+
+    COPYDATASTRUCT data = {};
+    data.dwData = COPYDATA_COMMAND_LINE;
+    data.cbData = static_cast<DWORD>((wcslen(commandLine) + 1) * sizeof(wchar_t));
+    data.lpData = const_cast<wchar_t*>(commandLine);
+
+    DWORD_PTR result = 0;
+    return SendMessageTimeoutW(hWndResident, WM_COPYDATA, 0, reinterpret_cast<LPARAM>(&data),
+        SMTO_ABORTIFHUNG, SEND_TIMEOUT_MS, &result) && result == TRUE;
+}
+
+bool SingleInstance::ReadCommandLine(const COPYDATASTRUCT* pData, std::wstring& commandLine)
+{
+    if (!pData || pData->dwData != COPYDATA_COMMAND_LINE || !pData->lpData
+        || pData->cbData < sizeof(wchar_t) || pData->cbData % sizeof(wchar_t) != 0)
+        return false;
+
+    const wchar_t* pText = static_cast<const wchar_t*>(pData->lpData);
+    size_t length = pData->cbData / sizeof(wchar_t);
+    if (pText[length - 1] != L'\0')
+        return false;
+
+    commandLine.assign(pText, length - 1);
+    return true;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "framework.h"
+#include <string>
+
+// Keeps one resident process per session. The first process owns a named
+// mutex; later launches hand their command line to its main window with
+// WM_COPYDATA and exit, so `cpp.exe --show-overlay` costs a window lookup
+// and one message instead of a cold start.
+class SingleInstance
+{
+private:
+    static constexpr const wchar_t* MUTEX_NAME = L"Local\\PointerEventsNone.Resident";
+    static constexpr DWORD FIND_WINDOW_TIMEOUT_MS = 2000;
+    static constexpr DWORD FIND_WINDOW_RETRY_MS = 50;
+    static constexpr UINT SEND_TIMEOUT_MS = 5000;
+
+    HANDLE m_hMutex;
+
+public:
+    // WM_COPYDATA dwData of a forwarded command line.
+    static constexpr ULONG_PTR COPYDATA_COMMAND_LINE = 0x504E4301;
+
+    SingleInstance();
+    ~SingleInstance();
+    SingleInstance(const SingleInstance&) = delete;
+    SingleInstance& operator=(const SingleInstance&) = delete;
+
+    // True when this process is the resident one.
+    bool Acquire();
+
+    // Sends `commandLine` to the resident instance's window of class
+    // `windowClass`, waiting briefly for it to be created.
+    static bool Forward(const wchar_t* windowClass, const wchar_t* commandLine);
+    // Validates a WM_COPYDATA payload and extracts the command line from it.
+    static bool ReadCommandLine(const COPYDATASTRUCT* pData, std::wstring& commandLine);
+};
@@ -3,12 +3,17 @@
 
 #include "framework.h"
 #include "cpp.h"
-#include "OverlayWindow.h"
-#include <gdiplus.h>
+#include "OverlayManager.h"
+#include "OverlayCommandQueue.h"
+#include "ResourcePool.h"
+#include "OverlayStats.h"
+#include "GdiPlusRuntime.h"
+#include "OverlayCommandLine.h"
+#include "SingleInstance.h"
+#include <memory>
+#include <uxtheme.h>
 
-#pragma comment(lib, "gdiplus.lib")
-
-using namespace Gdiplus;
+#pragma comment(lib, "uxtheme.lib")
 
 #define MAX_LOADSTRING 100
 
@@ -17,13 +22,20 @@ HINSTANCE hInst;                                // current instance
 WCHAR szTitle[MAX_LOADSTRING];                  // The title bar text
 WCHAR szWindowClass[MAX_LOADSTRING];            // the main window class name
 HWND hButtonShowOverlay;                        // Button handle
-ULONG_PTR gdiplusToken;
+HFONT hTitleFont;                               // Cached WM_PAINT font, per DPI
+std::unique_ptr<OverlayManager> overlayManager; // Owns every overlay window
+std::unique_ptr<OverlayCommandQueue> overlayCommands; // Batches requests per frame
 
 // Forward declarations of functions included in this code module:
 ATOM                MyRegisterClass(HINSTANCE hInstance);
 BOOL                InitInstance(HINSTANCE, int);
 LRESULT CALLBACK    WndProc(HWND, UINT, WPARAM, LPARAM);
 INT_PTR CALLBACK    About(HWND, UINT, WPARAM, LPARAM);
+void                CreatePaintResources(HWND);
+void                DestroyPaintResources();
+void                LayoutControls(HWND);
+void                PaintMainWindow(HWND);
+void                RunForwardedCommand(HWND, const wchar_t*);
 
 int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
                      _In_opt_ HINSTANCE hPrevInstance,
@@ -31,23 +43,63 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
                      _In_ int       nCmdShow)
 {
     UNREFERENCED_PARAMETER(hPrevInstance);
-    UNREFERENCED_PARAMETER(lpCmdLine);
+    OverlayStats::Shared().SetHudEnabled(HasCommandLineSwitch(lpCmdLine, L"--stats-hud"));
+    bool prewarm = !HasCommandLineSwitch(lpCmdLine, L"--no-prewarm");
+    bool prewarmOverlay = HasCommandLineSwitch(lpCmdLine, L"--prewarm-overlay");
 
-    // Initialize GDI+
-    GdiplusStartupInput gdiplusStartupInput;
-    GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, nullptr);
+    // Overlays are laid out in physical pixels per monitor so they are never
+    // bitmap-stretched by DWM on monitors with a different scale.
+    SetProcessDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
 
     // Initialize global strings
     LoadStringW(hInstance, IDS_APP_TITLE, szTitle, MAX_LOADSTRING);
     LoadStringW(hInstance, IDC_CPP, szWindowClass, MAX_LOADSTRING);
+
+    // Later launches hand their command line to the resident instance and
+    // exit before paying for any of the startup below.
+    SingleInstance singleInstance;
+    if (!singleInstance.Acquire())
+    {
+        return SingleInstance::Forward(szWindowClass, lpCmdLine) ? 0 : 1;
+    }
+
+    // `--show-overlay` starts the resident instance without its main window;
+    // a later plain launch brings the window up.
+    bool showOverlay = HasCommandLineSwitch(lpCmdLine, L"--show-overlay");
+    if (showOverlay)
+    {
+        nCmdShow = SW_HIDE;
+    }
+
     MyRegisterClass(hInstance);
 
+    BufferedPaintInit();
+
     // Perform application initialization:
     if (!InitInstance (hInstance, nCmdShow))
     {
         return FALSE;
     }
 
+    // GDI+ is started on the first overlay; warming it up now, after the
+    // window is on screen, keeps it off both the startup and the click path.
+    if (prewarm)
+    {
+        GdiPlusRuntime::Shared().StartPrewarm();
+    }
+
+    // Operator-triggered shows want click-to-visible latency, not startup
+    // time: keep a hidden overlay ready with its face already rendered.
+    if (prewarmOverlay)
+    {
+        overlayManager->Prewarm();
+    }
+
+    if (showOverlay)
+    {
+        overlayManager->ShowOverlay(ParseOverlayOptions(lpCmdLine));
+    }
+
     HACCEL hAccelTable = LoadAccelerators(hInstance, MAKEINTRESOURCE(IDC_CPP));
 
     MSG msg;
@@ -62,8 +114,14 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
         }
     }
 
-    // Shutdown GDI+
-    GdiplusShutdown(gdiplusToken);
+    // Buffered paint is only used by the main window.
+    BufferedPaintUnInit();
+
+    // Release live and pooled overlays, then shut down GDI+
+    overlayCommands.reset();
+    overlayManager.reset();
+    ResourcePool::Shared().Clear();
+    GdiPlusRuntime::Shared().Shutdown();
 
     return (int) msg.wParam;
 }
@@ -109,6 +167,7 @@ ATOM MyRegisterClass(HINSTANCE hInstance)
 BOOL InitInstance(HINSTANCE hInstance, int nCmdShow)
 {
    hInst = hInstance; // Store instance handle in our global variable
+   overlayManager = std::make_unique<OverlayManager>(hInstance);
 
    HWND hWnd = CreateWindowW(szWindowClass, L"C++", WS_OVERLAPPEDWINDOW,
       CW_USEDEFAULT, 0, 800, 450, nullptr, nullptr, hInstance, nullptr);
@@ -118,6 +177,8 @@ BOOL InitInstance(HINSTANCE hInstance, int nCmdShow)
       return FALSE;
    }
 
+   overlayCommands = std::make_unique<OverlayCommandQueue>(*overlayManager, hWnd);
+
    hButtonShowOverlay = CreateWindowW(
        L"BUTTON",
        L"オーバーレイを表示",
@@ -128,12 +189,124 @@ BOOL InitInstance(HINSTANCE hInstance, int nCmdShow)
        hInstance,
        nullptr);
 
+   CreatePaintResources(hWnd);
+   LayoutControls(hWnd);
+
    ShowWindow(hWnd, nCmdShow);
    UpdateWindow(hWnd);
 
    return TRUE;
 }
 
+//
+//  FUNCTION: CreatePaintResources(HWND)
+//
+//  PURPOSE: (Re)creates the GDI objects WM_PAINT uses, for the window's DPI.
+//
+//  COMMENTS:
+//
+//        Creating the font on every paint costs a font-mapper lookup each
+//        time the window repaints underneath a fading overlay. It is created
+//        once and only rebuilt on WM_DPICHANGED and WM_SETTINGCHANGE.
+//
+void CreatePaintResources(HWND hWnd)
+{
+    DestroyPaintResources();
+
+    UINT dpi = GetDpiForWindow(hWnd);
+    hTitleFont = CreateFontW(MulDiv(24, dpi, USER_DEFAULT_SCREEN_DPI), 0, 0, 0, FW_BOLD, FALSE, FALSE, FALSE,
+        DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
+        DEFAULT_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"MS Gothic");
+}
+
+void DestroyPaintResources()
+{
+    if (hTitleFont)
+    {
+        DeleteObject(hTitleFont);
+        hTitleFont = nullptr;
+    }
+}
+
+//
+//  FUNCTION: LayoutControls(HWND)
+//
+//  PURPOSE: Places the button in DPI-scaled coordinates.
+//
+void LayoutControls(HWND hWnd)
+{
+    UINT dpi = GetDpiForWindow(hWnd);
+    SetWindowPos(hButtonShowOverlay, nullptr,
+        MulDiv(300, dpi, USER_DEFAULT_SCREEN_DPI), MulDiv(175, dpi, USER_DEFAULT_SCREEN_DPI),
+        MulDiv(200, dpi, USER_DEFAULT_SCREEN_DPI), MulDiv(50, dpi, USER_DEFAULT_SCREEN_DPI),
+        SWP_NOZORDER | SWP_NOACTIVATE);
+}
+
+//
+//  FUNCTION: PaintMainWindow(HWND)
+//
+//  PURPOSE: Paints the invalid part of the client area through an
+//           off-screen buffer, so repaints never flicker.
+//
+void PaintMainWindow(HWND hWnd)
+{
+    PAINTSTRUCT ps;
+    HDC hdc = BeginPaint(hWnd, &ps);
+
+    HDC hdcBuffer = nullptr;
+    HPAINTBUFFER hBuffer = BeginBufferedPaint(hdc, &ps.rcPaint, BPBF_COMPATIBLEBITMAP, nullptr, &hdcBuffer);
+    HDC hdcTarget = hBuffer ? hdcBuffer : hdc;
+
+    FillRect(hdcTarget, &ps.rcPaint, GetSysColorBrush(COLOR_WINDOW));
+
+    RECT rect;
+    GetClientRect(hWnd, &rect);
+    UINT dpi = GetDpiForWindow(hWnd);
+    RECT textRect = { 0, MulDiv(100, dpi, USER_DEFAULT_SCREEN_DPI), rect.right, MulDiv(140, dpi, USER_DEFAULT_SCREEN_DPI) };
+
+    RECT visibleText;
+    if (IntersectRect(&visibleText, &textRect, &ps.rcPaint))
+    {
+        HFONT hOldFont = (HFONT)SelectObject(hdcTarget, hTitleFont);
+        SetBkMode(hdcTarget, TRANSPARENT);
+        SetTextColor(hdcTarget, GetSysColor(COLOR_WINDOWTEXT));
+        DrawTextW(hdcTarget, L"クリックスルーウィンドウのテスト", -1, &textRect,
+            DT_CENTER | DT_SINGLELINE | DT_VCENTER);
+        SelectObject(hdcTarget, hOldFont);
+    }
+
+    if (hBuffer)
+    {
+        EndBufferedPaint(hBuffer, TRUE);
+    }
+    EndPaint(hWnd, &ps);
+}
+
+//
+//  FUNCTION: RunForwardedCommand(HWND, const wchar_t*)
+//
+//  PURPOSE: Acts on the command line of a later launch: queues a show for
+//           `--show-overlay` or a hide for `--hide-overlay`, otherwise
+//           brings the main window up.
+//
+void RunForwardedCommand(HWND hWnd, const wchar_t* commandLine)
+{
+    if (HasCommandLineSwitch(commandLine, L"--show-overlay"))
+    {
+        overlayCommands->Show(ParseOverlayOptions(commandLine));
+        return;
+    }
+
+    if (HasCommandLineSwitch(commandLine, L"--hide-overlay"))
+    {
+        overlayCommands->Hide();
+        return;
+    }
+
+    ShowWindow(hWnd, IsIconic(hWnd) ? SW_RESTORE : SW_SHOW);
+    SetForegroundWindow(hWnd);
+}
+
 //
 //  FUNCTION: WndProc(HWND, UINT, WPARAM, LPARAM)
 //
@@ -141,6 +314,7 @@ BOOL InitInstance(HINSTANCE hInstance, int nCmdShow)
 //
 //  WM_COMMAND  - process the application menu
 //  WM_PAINT    - Paint the main window
+//  WM_COPYDATA - run a command line forwarded by a later launch
 //  WM_DESTROY  - post a quit message and return
 //
 //
@@ -155,13 +329,7 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             switch (wmId)
             {
             case IDC_SHOW_OVERLAY:
-                {
-                    OverlayWindow* overlay = new OverlayWindow(hInst);
-                    if (overlay->Create())
-                    {
-                        overlay->Show();
-                    }
-                }
+                overlayCommands->Show();
                 break;
             case IDM_ABOUT:
                 DialogBox(hInst, MAKEINTRESOURCE(IDD_ABOUTBOX), hWnd, About);
@@ -174,31 +342,42 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             }
         }
         break;
+    case WM_COPYDATA:
+        {
+            // The sender only waits for the payload to be accepted, not for
+            // the overlay to be shown.
+            std::wstring commandLine;
+            if (!SingleInstance::ReadCommandLine(reinterpret_cast<const COPYDATASTRUCT*>(lParam), commandLine))
+                return FALSE;
+
+            ReplyMessage(TRUE);
+            RunForwardedCommand(hWnd, commandLine.c_str());
+        }
+        return TRUE;
+    case WM_ERASEBKGND:
+        // PaintMainWindow fills the background into its buffer.
+        return 1;
     case WM_PAINT:
+        PaintMainWindow(hWnd);
+        OverlayStats::Shared().RecordStartupPhase(StartupPhase::FirstPaint);
+        break;
+    case WM_DPICHANGED:
         {
-            PAINTSTRUCT ps;
-            HDC hdc = BeginPaint(hWnd, &ps);
-            
-            RECT rect;
-            GetClientRect(hWnd, &rect);
-            
-            HFONT hFont = CreateFontW(24, 0, 0, 0, FW_BOLD, FALSE, FALSE, FALSE,
-                DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
-                DEFAULT_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"MS Gothic");
-            HFONT hOldFont = (HFONT)SelectObject(hdc, hFont);
-            
-            SetBkMode(hdc, TRANSPARENT);
-            RECT textRect = { 0, 100, rect.right, 140 };
-            DrawTextW(hdc, L"クリックスルーウィンドウのテスト", -1, &textRect, 
-                DT_CENTER | DT_SINGLELINE | DT_VCENTER);
-            
-            SelectObject(hdc, hOldFont);
-            DeleteObject(hFont);
-            
-            EndPaint(hWnd, &ps);
+            RECT* pSuggested = reinterpret_cast<RECT*>(lParam);
+            SetWindowPos(hWnd, nullptr, pSuggested->left, pSuggested->top,
+                pSuggested->right - pSuggested->left, pSuggested->bottom - pSuggested->top,
+                SWP_NOZORDER | SWP_NOACTIVATE);
+            CreatePaintResources(hWnd);
+            LayoutControls(hWnd);
+            InvalidateRect(hWnd, nullptr, FALSE);
         }
         break;
+    case WM_SETTINGCHANGE:
+        CreatePaintResources(hWnd);
+        InvalidateRect(hWnd, nullptr, FALSE);
+        break;
     case WM_DESTROY:
+        DestroyPaintResources();
         PostQuitMessage(0);
         break;
     default:
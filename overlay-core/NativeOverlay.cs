@@ -0,0 +1,67 @@
+using System;
+using System.Runtime.InteropServices;
+
+namespace OverlayCore
+{
+    /// <summary>
+    /// Shows the native overlay from OverlayCore.dll, the engine the C++ app
+    /// uses. Linked into both the WPF and WinUI hosts. Call from the UI thread
+    /// only, and call <see cref="Shutdown"/> before the app exits. Every
+    /// method returns false when the DLL is not deployed next to the app, so
+    /// callers can fall back to their managed overlay window.
+    /// </summary>
+    internal static class NativeOverlay
+    {
+        private const string DllName = "OverlayCore.dll";
+
+        [DllImport(DllName, CharSet = CharSet.Unicode)]
+        private static extern int OverlayCore_Initialize();
+
+        [DllImport(DllName, CharSet = CharSet.Unicode)]
+        private static extern int OverlayCore_Show(string? arguments);
+
+        [DllImport(DllName, CharSet = CharSet.Unicode)]
+        private static extern int OverlayCore_Shutdown();
+
+        private static bool _initialized;
+        private static bool _unavailable;
+
+        /// <param name="arguments">Same switches as cpp.exe, e.g. "--seconds tick --fade-curve ease-out".</param>
+        public static bool TryShow(string? arguments = null)
+        {
+            if (!EnsureInitialized())
+            {
+                return false;
+            }
+
+            return OverlayCore_Show(arguments) == 0;
+        }
+
+        public static void Shutdown()
+        {
+            if (_initialized)
+            {
+                OverlayCore_Shutdown();
+                _initialized = false;
+            }
+        }
+
+        private static bool EnsureInitialized()
+        {
+            if (_initialized || _unavailable)
+            {
+                return _initialized;
+            }
+
+            try
+            {
+                _initialized = OverlayCore_Initialize() >= 0;
+            }
+            catch (Exception e) when (e is DllNotFoundException || e is EntryPointNotFoundException || e is BadImageFormatException)
+            {
+                _unavailable = true;
+            }
+            return _initialized;
+        }
+    }
+}
@@ -0,0 +1,141 @@
+#include "OverlayCore.h"
+#include "OverlayManager.h"
+#include "OverlayCommandLine.h"
+#include "ResourcePool.h"
+#include "GdiPlusRuntime.h"
+#include <memory>
+
+EXTERN_C IMAGE_DOS_HEADER __ImageBase;
+
+namespace
+{
+    std::unique_ptr<OverlayManager> g_overlayManager;
+    DWORD g_ownerThreadId = 0;
+    // Held from Initialize to Shutdown, so a host that unloads the DLL with
+    // overlays still alive can't free their window procedure under them.
+    HMODULE g_hModuleReference = nullptr;
+
+    HINSTANCE GetModuleInstance()
+    {
+        return reinterpret_cast<HINSTANCE>(&__ImageBase);
+    }
+
+    HRESULT CheckOwnerThread()
+    {
+        if (!g_overlayManager)
+            return E_NOT_VALID_STATE;
+        if (GetCurrentThreadId() != g_ownerThreadId)
+            return RPC_E_WRONG_THREAD;
+        return S_OK;
+    }
+
+    // Hosts are not necessarily per-monitor aware; the overlays are, so they
+    // are never bitmap-stretched by DWM. The context sticks to each window
+    // at creation.
+    class PerMonitorDpiScope
+    {
+    private:
+        DPI_AWARENESS_CONTEXT m_previous;
+
+    public:
+        PerMonitorDpiScope()
+            : m_previous(SetThreadDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2))
+        {
+        }
+
+        ~PerMonitorDpiScope()
+        {
+            if (m_previous)
+            {
+                SetThreadDpiAwarenessContext(m_previous);
+            }
+        }
+
+        PerMonitorDpiScope(const PerMonitorDpiScope&) = delete;
+        PerMonitorDpiScope& operator=(const PerMonitorDpiScope&) = delete;
+    };
+}
+
+OVERLAYCORE_API HRESULT WINAPI OverlayCore_Initialize()
+{
+    if (g_overlayManager)
+        return CheckOwnerThread();
+
+    g_overlayManager = std::make_unique<OverlayManager>(GetModuleInstance());
+    g_ownerThreadId = GetCurrentThreadId();
+    GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, reinterpret_cast<LPCWSTR>(&__ImageBase), &g_hModuleReference);
+    GdiPlusRuntime::Shared().StartPrewarm();
+    return S_OK;
+}
+
+OVERLAYCORE_API HRESULT WINAPI OverlayCore_Show(const wchar_t* arguments)
+{
+    HRESULT hr = CheckOwnerThread();
+    if (FAILED(hr))
+        return hr;
+
+    PerMonitorDpiScope dpiScope;
+    return g_overlayManager->ShowOverlay(ParseOverlayOptions(arguments)) ? S_OK : S_FALSE;
+}
+
+OVERLAYCORE_API HRESULT WINAPI OverlayCore_Prewarm(const wchar_t* arguments)
+{
+    HRESULT hr = CheckOwnerThread();
+    if (FAILED(hr))
+        return hr;
+
+    PerMonitorDpiScope dpiScope;
+    return g_overlayManager->Prewarm(ParseOverlayOptions(arguments)) > 0 ? S_OK : S_FALSE;
+}
+
+OVERLAYCORE_API HRESULT WINAPI OverlayCore_Hide()
+{
+    HRESULT hr = CheckOwnerThread();
+    if (FAILED(hr))
+        return hr;
+
+    g_overlayManager->HideOverlays();
+    return S_OK;
+}
+
+// Same order as cpp.exe's exit: windows first, then GDI+. The window class
+// belongs to this module, so it is unregistered too. The caller still holds
+// its own reference to the DLL, so dropping ours can't unload it mid-call.
+OVERLAYCORE_API HRESULT WINAPI OverlayCore_Shutdown()
+{
+    HRESULT hr = CheckOwnerThread();
+    if (FAILED(hr))
+        return hr;
+
+    g_overlayManager.reset();
+    ResourcePool::Shared().Clear();
+    GdiPlusRuntime::Shared().Shutdown();
+    OverlayWindow::UnregisterWindowClass(GetModuleInstance());
+    g_ownerThreadId = 0;
+    if (g_hModuleReference)
+    {
+        FreeLibrary(g_hModuleReference);
+        g_hModuleReference = nullptr;
+    }
+    return S_OK;
+}
+
+// With the reference above, the DLL is only detached with the engine still
+// up when the process exits and the host never called OverlayCore_Shutdown.
+// Tearing down then would destroy windows and join threads under the loader
+// lock, so the live overlays, the pool with its parked windows, and GDI+
+// are all left to the OS instead. The CRT runs static destructors after
+// this returns, and with everything abandoned they find nothing to do.
+BOOL APIENTRY DllMain(HMODULE hModule, DWORD reason, LPVOID lpReserved)
+{
+    UNREFERENCED_PARAMETER(hModule);
+
+    if (reason == DLL_PROCESS_DETACH && lpReserved && g_overlayManager)
+    {
+        OverlayManager* pAbandoned = g_overlayManager.release();
+        UNREFERENCED_PARAMETER(pAbandoned);
+        ResourcePool::Shared().Abandon();
+        GdiPlusRuntime::Shared().Abandon();
+    }
+    return TRUE;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <windows.h>
+
+// C ABI over the native overlay engine in cpp/, so the WPF and WinUI hosts
+// can show the same click-through clock without a managed rendering
+// pipeline.
+//
+// Every call must come from one thread that pumps window messages, e.g. the
+// WPF dispatcher thread or the WinUI UI thread: overlays are windows owned by
+// that thread and are driven by its message loop. Calls from other threads
+// fail with RPC_E_WRONG_THREAD. OverlayCore_Shutdown is required: until it
+// runs the DLL keeps itself loaded, and a process that exits without it
+// leaves the overlays and GDI+ to the OS.
+//
+// Options are passed as the same switches cpp.exe takes, e.g.
+// L"--monitors all --anchor top-right --seconds tick --fade-curve ease-out".
+// Unknown switches are ignored.
+
+#ifdef OVERLAYCORE_EXPORTS
+#define OVERLAYCORE_API extern "C" __declspec(dllexport)
+#else
+#define OVERLAYCORE_API extern "C" __declspec(dllimport)
+#endif
+
+// Binds the engine to the calling thread and loads GDI+ in the background.
+// Calling it again from the same thread is a no-op.
+OVERLAYCORE_API HRESULT WINAPI OverlayCore_Initialize();
+
+// Shows an overlay; `arguments` may be null for the defaults. Returns S_FALSE
+// when no overlay could be shown.
+OVERLAYCORE_API HRESULT WINAPI OverlayCore_Show(const wchar_t* arguments);
+
+// Parks hidden overlays with their face already drawn, so the next show with
+// the same arguments only draws the hands.
+OVERLAYCORE_API HRESULT WINAPI OverlayCore_Prewarm(const wchar_t* arguments);
+
+// Ends every visible overlay's fade now.
+OVERLAYCORE_API HRESULT WINAPI OverlayCore_Hide();
+
+// Destroys live and parked overlays and shuts GDI+ down.
+OVERLAYCORE_API HRESULT WINAPI OverlayCore_Shutdown();
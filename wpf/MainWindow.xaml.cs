@@ -10,6 +10,7 @@ using System.Windows.Media;
 using System.Windows.Media.Imaging;
 using System.Windows.Navigation;
 using System.Windows.Shapes;
+using OverlayCore;
 
 namespace wpf
 {
@@ -21,10 +22,16 @@ namespace wpf
         public MainWindow()
         {
             InitializeComponent();
+            Closed += (_, _) => NativeOverlay.Shutdown();
         }
 
         private void ShowOverlay_Click(object sender, RoutedEventArgs e)
         {
+            if (NativeOverlay.TryShow())
+            {
+                return;
+            }
+
             var overlayWindow = new OverlayWindow();
             overlayWindow.Show();
         }